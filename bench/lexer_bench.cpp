@@ -0,0 +1,239 @@
+// Lexer throughput benchmark
+// > Build : the lexer_bench target, run_lexer_bench builds and runs it
+// > Run : lexer_bench [corpus directory]
+// > Corpora are generated from fixed seeds, a directory argument also writes each one out to be inspected or reused
+// > Only includes lexer.hpp, so checking out an earlier revision and rebuilding measures that revision
+
+#include "../lexer.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <new>
+#include <random>
+#include <string>
+
+//=========================
+// Allocation counting
+//=========================
+
+static size_t allocationCount = 0;
+
+void* operator new(size_t _size)
+{
+  allocationCount++;
+  void* block = malloc(_size);
+  if (block == nullptr)
+    throw std::bad_alloc();
+  return block;
+}
+
+void operator delete(void* _block) noexcept
+{
+  free(_block);
+}
+
+void operator delete(void* _block, size_t) noexcept
+{
+  free(_block);
+}
+
+//=========================
+// Corpora
+//=========================
+
+enum BenchWorkload
+{
+  Workload_Identifiers, // Lowercase words split by spaces and newlines
+  Workload_Numbers, // Integers and decimals split by ", "
+  Workload_Whitespace, // Long runs of spaces, tabs and newlines between single characters
+  Workload_Lines, // Lines of 20-80 characters, split with ReadTo('\n')
+  Workload_Assignments, // "keyN = N;" lines, parsed with ExpectType and ExpectString
+  Workload_MixedIdentifiers, // Mixed case identifiers with digits and '_', split by spaces and ",\n"
+  Workload_Count
+};
+
+const char* workloadNames[Workload_Count] = { "identifiers", "numbers", "whitespace", "ReadTo lines",
+                                              "ExpectString parse", "mixed identifiers" };
+
+// Builds a corpus of at least _size bytes, identical for every run
+std::string GenerateCorpus(BenchWorkload _workload, size_t _size)
+{
+  std::mt19937 random(1);
+  std::string corpus;
+  corpus.reserve(_size + 128);
+
+  while (corpus.size() < _size)
+  {
+    switch (_workload)
+    {
+    case Workload_Identifiers:
+    {
+      int length = 3 + random() % 12;
+      for (int i = 0; i < length; i++)
+        corpus += (char)('a' + random() % 26);
+      corpus += (random() % 8 == 0) ? '\n' : ' ';
+    } break;
+    case Workload_Numbers:
+    {
+      corpus += std::to_string(random() % 100000);
+      if (random() % 2)
+      {
+        corpus += '.';
+        corpus += std::to_string(random() % 1000);
+      }
+      corpus += ", ";
+    } break;
+    case Workload_Whitespace:
+    {
+      int length = 1 + random() % 30;
+      for (int i = 0; i < length; i++)
+        corpus += " \t\n"[random() % 3];
+      corpus += 'x';
+    } break;
+    case Workload_Lines:
+    {
+      int length = 20 + random() % 60;
+      for (int i = 0; i < length; i++)
+        corpus += (char)('a' + random() % 26);
+      corpus += '\n';
+    } break;
+    case Workload_Assignments:
+    {
+      corpus += "key" + std::to_string(random() % 100) + " = " + std::to_string(random() % 1000) + ";\n";
+    } break;
+    case Workload_MixedIdentifiers:
+    {
+      const char* characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+      int length = 3 + random() % 14;
+      corpus += characters[random() % 53]; // Identifiers do not start with a digit
+      for (int i = 1; i < length; i++)
+        corpus += characters[random() % 63];
+      corpus += (random() % 8 == 0) ? ",\n" : " ";
+    } break;
+    default: return corpus;
+    }
+  }
+
+  return corpus;
+}
+
+// Writes the corpus to _directory/_name.txt
+void WriteCorpus(const char* _directory, const char* _name, const std::string& _corpus)
+{
+  std::string path = std::string(_directory) + "/" + _name + ".txt";
+  for (char& c : path)
+    c = (c == ' ') ? '_' : c;
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr)
+  {
+    printf("Failed to write corpus \"%s\"\n", path.c_str());
+    return;
+  }
+
+  fwrite(_corpus.data(), 1, _corpus.size(), file);
+  fclose(file);
+}
+
+//=========================
+// Workloads
+//=========================
+
+// Lexes the whole stream as the workload describes, returning the number of tokens read
+template <typename LexerType>
+size_t RunWorkload(BenchWorkload _workload, LexerType& _lexer)
+{
+  size_t tokens = 0;
+
+  switch (_workload)
+  {
+  case Workload_Lines:
+  {
+    while (!_lexer.CompletedStream())
+    {
+      _lexer.ReadTo('\n');
+      _lexer.Read(1);
+      tokens++;
+    }
+  } break;
+  case Workload_Assignments:
+  {
+    while (!_lexer.CompletedStream())
+    {
+      typename LexerType::Token key;
+      if (!_lexer.ExpectType(YTools::Token_String, &key))
+        break;
+      _lexer.ExpectString("=");
+      _lexer.NextToken();
+      _lexer.ExpectString(";");
+      tokens += 4;
+    }
+  } break;
+  default:
+  {
+    while (_lexer.NextToken().type != YTools::Token_End)
+      tokens++;
+  } break;
+  }
+
+  return tokens;
+}
+
+// Times _repetitions full passes over the corpus and prints one result row
+// _sizeName : Names the corpus size in the printed row
+template <typename LexerType>
+void MeasureWorkload(BenchWorkload _workload,
+                     const char* _sizeName,
+                     const char* _lexerName,
+                     const std::string& _corpus,
+                     int _repetitions)
+{
+  size_t tokens = 0;
+  allocationCount = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < _repetitions; i++)
+  {
+    LexerType lexer(_corpus);
+    tokens += RunWorkload(_workload, lexer);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("  %-6s %-19s %-10s %5.0f %7.1f %5.2f\n",
+         _sizeName,
+         workloadNames[_workload],
+         _lexerName,
+         (double)_corpus.size() * _repetitions / seconds / 1e6,
+         (double)tokens / seconds / 1e6,
+         tokens ? (double)allocationCount / tokens : 0.0);
+}
+
+int main(int _argc, char** _argv)
+{
+  const char* corpusDirectory = (_argc > 1) ? _argv[1] : nullptr;
+
+  struct
+  {
+    const char* name;
+    size_t size;
+    int repetitions;
+  } sizes[] = { { "4KB", 4096, 20000 }, { "64MB", 64u << 20, 3 } };
+
+  printf("  corpus workload            lexer       MB/s  Mtok/s alloc/tok\n");
+  for (const auto& size : sizes)
+  {
+    for (int workload = 0; workload < Workload_Count; workload++)
+    {
+      std::string corpus = GenerateCorpus((BenchWorkload)workload, size.size);
+      if (corpusDirectory != nullptr)
+        WriteCorpus(corpusDirectory, (std::string(size.name) + "_" + workloadNames[workload]).c_str(), corpus);
+
+      MeasureWorkload<YTools::Lexer>((BenchWorkload)workload, size.name, "Lexer", corpus, size.repetitions);
+      MeasureWorkload<YTools::LexerView>((BenchWorkload)workload, size.name, "LexerView", corpus, size.repetitions);
+    }
+  }
+
+  return 0;
+}
@@ -2,10 +2,88 @@
 #ifndef YTOOLS_LEXER_H_
 #define YTOOLS_LEXER_H_
 
+#include <locale.h> // Read by the float fallback without a floating std::from_chars
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <charconv> // Used as the exact fallback for float parsing
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory> // std::destroy_at, rebuilding pmr out-tokens on the lexer's resource
+#include <memory_resource> // Optional allocation of token strings and batches from an arena
+#include <new>
+#include <optional>
 #include <string>
 #include <string_view> // Used to create sub-strings from the input string
+#include <thread>
 #include <vector>
 
+// std::ranges concepts check the token range where the library provides them
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_ranges)
+#include <ranges>
+#endif // __cpp_lib_ranges
+
+// SIMD scanning kernels are selected at compile time
+// > Define YTOOLS_LEXER_NO_SIMD to force the scalar fallback
+#if !defined(YTOOLS_LEXER_NO_SIMD)
+#if defined(__AVX2__)
+#define YTOOLS_LEXER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YTOOLS_LEXER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define YTOOLS_LEXER_NEON
+#include <arm_neon.h>
+#endif
+#endif // !YTOOLS_LEXER_NO_SIMD
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Used by LexerMappedFile
+// > min/max stay undefined, calls to numeric_limits are parenthesized for includers that define them
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#define YTOOLS_LEXER_UNDEF_NOMINMAX
+#endif
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#define YTOOLS_LEXER_UNDEF_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#if defined(YTOOLS_LEXER_UNDEF_NOMINMAX)
+#undef NOMINMAX
+#undef YTOOLS_LEXER_UNDEF_NOMINMAX
+#endif
+#if defined(YTOOLS_LEXER_UNDEF_LEAN_AND_MEAN)
+#undef WIN32_LEAN_AND_MEAN
+#undef YTOOLS_LEXER_UNDEF_LEAN_AND_MEAN
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // Platforms
+
+// Define YTOOLS_LEXER_STATS to count each lexer's work, see LexerStats
+// > Compiled out otherwise, statements in YTOOLS_LEXER_STAT are removed
+#if defined(YTOOLS_LEXER_STATS)
+#include "logger.hpp"
+#define YTOOLS_LEXER_STAT(_statement) _statement
+#else
+#define YTOOLS_LEXER_STAT(_statement)
+#endif // YTOOLS_LEXER_STATS
+
 namespace YTools {
   enum TokenTypes
   {
@@ -42,591 +120,2900 @@ namespace YTools {
 
     Token_NullTerminator,
     Token_Whitespace,
+    Token_Comment,       // Only produced by policies with comment syntax, includes the delimiters
+    Token_StringLiteral, // Only produced by policies with string quotes, includes the quotes
   };
 
-  struct LexerToken
+  //=========================
+  // Character classification
+  //=========================
+
+  enum LexerCharacterFlags : unsigned char
   {
-    YTools::TokenTypes type{};
-    std::string string{};
-    const char* start = 0;
-    const char* end = 0;
+    Char_Whitespace      = 1 << 0, // ' ', '\n', '\r', '\t'
+    Char_Digit           = 1 << 1, // [0-9]
+    Char_Hex             = 1 << 2, // [0-9], [a-f], [A-F]
+    Char_Identifier      = 1 << 3, // Continues a string token : [0-9], [a-z], [A-Z], '_', '-'
+    Char_IdentifierStart = 1 << 4, // Begins a string token : [a-z], [A-Z], '_'
+    Char_Decimal         = 1 << 5, // Continues a decimal or float token : [0-9], '.'
+    Char_NumberStart     = 1 << 6, // Begins a number token : [0-9], '-'
   };
 
-  class Lexer
+  struct LexerCharacter
   {
-  private:
-    const char* charStream; // The string to be read from 
-    const char* const streamStart; // Used in GetProgress
-    const char* const streamEnd; // Used to avoid requiring \0 at the end of the string
-    const bool usesHex; // Defines how number identification handles a,b,c,d,e,f,A,B,C,D,E,F
-
-  public:
-    Lexer(const char* _str, size_t _size, bool _useHex = false) : charStream(_str),
-                                                                  streamStart(_str),
-                                                                  streamEnd(streamStart + _size - 1),
-                                                                  usesHex(_useHex)
-    {}
-
-    Lexer(const std::vector<char>& _str, bool _useHex = false) : charStream(_str.data()),
-                                                                 streamStart(_str.data()),
-                                                                 streamEnd(streamStart + _str.size() - 1),
-                                                                 usesHex(_useHex)
-    {}
+    YTools::TokenTypes type = Token_Unknown; // The type of token this character begins
+    unsigned char flags = 0; // LexerCharacterFlags
+  };
 
-    Lexer(const std::string& _str, bool _useHex = false) : charStream(_str.data()),
-                                                           streamStart(_str.data()),
-                                                           streamEnd(streamStart + _str.size() - 1),
-                                                           usesHex(_useHex)
-    {}
+  struct LexerCharacterTable
+  {
+    LexerCharacter characters[256];
 
-    //=========================
-    // Token retrieval
-    //=========================
+    constexpr const LexerCharacter& operator[](char _char) const
+    {
+      return characters[(unsigned char)_char];
+    }
 
-    // Returns a token containing the string up to the next whitespace character
-    // _expectHex (Optional) : overrides [a/A - f/F] as numeric values at the start of a token
-    // _includeWhitespace (Optional) : Will treat whitespace as tokens when true
-    YTools::LexerToken NextToken(bool _expectHex = false, bool _includeWhitespace = false)
+    // Returns true if both tables give the flags to the same characters
+    constexpr bool SameFlags(const LexerCharacterTable& _other, unsigned char _flags) const
     {
-      if (!_includeWhitespace)
+      for (unsigned int i = 0; i < 256; i++)
       {
-        SkipWhitespace();
+        if ((characters[i].flags & _flags) != (_other.characters[i].flags & _flags))
+          return false;
       }
 
-      if (CompletedStream())
-      {
-        return { Token_End, "", charStream, charStream };
-      }
+      return true;
+    }
+  };
 
-      // Get token =====
-      switch (*charStream)
-      {
-      case '-':
-      case '0': case '1': case '2': case '3': case '4':
-      case '5': case '6': case '7': case '8': case '9':
-        return GetNumberToken(usesHex);
-      case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
-      case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
-      {
-        if (_expectHex)
-        {
-          return GetNumberToken(true);
-        }
-      }
-      case 'G': case 'H': case 'I': case 'J': case 'K': case 'L':
-      case 'M': case 'N': case 'O': case 'P': case 'Q': case 'R':
-      case 'S': case 'T': case 'U': case 'V': case 'W': case 'X':
-      case 'Y': case 'Z':
-      case '_':
-      case 'g': case 'h': case 'i': case 'j': case 'k': case 'l':
-      case 'm': case 'n': case 'o': case 'p': case 'q': case 'r':
-      case 's': case 't': case 'u': case 'v': case 'w': case 'x':
-      case 'y': case 'z':
-        return GetStringToken();
-      case ',': return GetSingleCharToken(Token_Comma);
-      case '[': return GetSingleCharToken(Token_LeftBracket);
-      case ']': return GetSingleCharToken(Token_RightBracket);
-      case '{': return GetSingleCharToken(Token_LeftBrace);
-      case '}': return GetSingleCharToken(Token_RightBrace);
-      case '(': return GetSingleCharToken(Token_LeftParen);
-      case ')': return GetSingleCharToken(Token_RightParen);
-      case '/': return GetSingleCharToken(Token_FwdSlash);
-
-      case '<': return GetSingleCharToken(Token_LessThan);
-      case '>': return GetSingleCharToken(Token_GreaterThan);
-      case '=': return GetSingleCharToken(Token_Equal);
-      case '+': return GetSingleCharToken(Token_Plus);
-      case '*': return GetSingleCharToken(Token_Star);
-      case '\\': return GetSingleCharToken(Token_BackSlash);
-      case '#': return GetSingleCharToken(Token_Pound);
-      case '.': return GetSingleCharToken(Token_Period);
-      case ';': return GetSingleCharToken(Token_SemiColon);
-      case ':': return GetSingleCharToken(Token_Colon);
-      case '\'': return GetSingleCharToken(Token_Apostrophe);
-      case '"': return GetSingleCharToken(Token_Quote);
-      case '|': return GetSingleCharToken(Token_Pipe);
-
-      case '\0': return GetSingleCharToken(Token_NullTerminator);
-
-        // The whitespace skip prevents this from being called when _includeWhitespace is false
-      case ' ': case '\n': case '\r': case '\t':
-        return GetWhitespaceToken();
+  constexpr LexerCharacterTable BuildLexerCharacterTable()
+  {
+    LexerCharacterTable table{};
 
-      default: return GetSingleCharToken(Token_Unknown);
-      }
-    }
+    // Single-char tokens =====
+    const char singleChars[] = ",[]{}()/<>=+*\\#.;:'\"|";
+    const YTools::TokenTypes singleTypes[] = {
+      Token_Comma, Token_LeftBracket, Token_RightBracket, Token_LeftBrace, Token_RightBrace,
+      Token_LeftParen, Token_RightParen, Token_FwdSlash, Token_LessThan, Token_GreaterThan,
+      Token_Equal, Token_Plus, Token_Star, Token_BackSlash, Token_Pound, Token_Period,
+      Token_SemiColon, Token_Colon, Token_Apostrophe, Token_Quote, Token_Pipe };
 
-    // Reads the next token and compares it with the given string
-    // Returns true and outputs the read token if they match
-    // Returns false if they do not match, Does not move forward in the read string
-    // _expected : The string to compare against
-    // _outToken (Optional) : Output for the read expected string if found
-    bool ExpectString(std::string _expected, YTools::LexerToken* _outToken = nullptr)
+    for (unsigned int i = 0; i < sizeof(singleTypes) / sizeof(singleTypes[0]); i++)
     {
-      const char* prevCharHead = charStream;
+      table.characters[(unsigned char)singleChars[i]].type = singleTypes[i];
+    }
 
-      if (!IsWhiteSpace(_expected.c_str()[0]))
-        SkipWhitespace();
+    table.characters[(unsigned char)'\0'].type = Token_NullTerminator;
 
-      YTools::LexerToken next = Read(_expected.size());
+    // Whitespace =====
+    const char whitespace[] = { ' ', '\n', '\r', '\t' };
+    for (char c : whitespace)
+    {
+      table.characters[(unsigned char)c] = { Token_Whitespace, Char_Whitespace };
+    }
 
-      if (next.string.compare(_expected) == 0)
-      {
-        if (_outToken != nullptr)
-          *_outToken = next;
+    // Letters =====
+    for (int c = 0; c < 26; c++)
+    {
+      unsigned char flags = Char_Identifier | Char_IdentifierStart | (c < 6 ? Char_Hex : 0);
+      table.characters['a' + c] = { Token_String, flags };
+      table.characters['A' + c] = { Token_String, flags };
+    }
 
-        return true;
-      }
+    table.characters[(unsigned char)'_'] = { Token_String, Char_Identifier | Char_IdentifierStart };
 
-      // Undo token read
-      charStream = prevCharHead;
-      return false;
+    // Numbers =====
+    for (int c = '0'; c <= '9'; c++)
+    {
+      table.characters[c] = { Token_Decimal,
+                              Char_Digit | Char_Hex | Char_Identifier | Char_Decimal | Char_NumberStart };
     }
 
-    // Reads the next token and compares its type with the given type
-    // Returns true and outputs the token if they match
-    // Returns false if they do not match, Does not move forward in the read string
-    // _expected : The type to compare against
-    // _outToken (Optional) : Output for the read string if the types match
-    bool ExpectType(YTools::TokenTypes _expected, YTools::LexerToken* _outToken = nullptr)
-    {
-      const char* prevCharHead = charStream;
+    table.characters[(unsigned char)'-'] = { Token_Decimal, Char_Identifier | Char_NumberStart };
+    table.characters[(unsigned char)'.'].flags = Char_Decimal;
 
-      if (_expected != Token_Whitespace)
-        SkipWhitespace();
+    return table;
+  }
 
-      YTools::LexerToken next = NextToken(_expected == Token_Hex);
+  // Classification of every character value, indexed by (unsigned char)
+  inline constexpr LexerCharacterTable lexerCharacters = BuildLexerCharacterTable();
 
-      if (next.type == _expected)
-      {
-        if (_outToken != nullptr)
-          *_outToken = next;
+  //=========================
+  // Policies
+  //=========================
 
-        return true;
-      }
+  // How a lexer policy decides an option
+  enum LexerOption
+  {
+    Option_Runtime, // Decided by the constructor and call arguments
+    Option_Never,   // Always off, the arguments are ignored
+    Option_Always,  // Always on, the arguments are ignored
+  };
 
-      // Undo token read
-      charStream = prevCharHead;
-      return false;
-    }
+  // The compile-time configuration of a BasicLexer
+  // > Derive from it and redeclare the members to change, each policy gets its own scanner with the
+  //   policy's options folded away at compile time
+  // > struct IniPolicy : YTools::LexerDefaultPolicy
+  //   {
+  //     static constexpr YTools::LexerCharacterTable characters = BuildIniCharacters();
+  //     static constexpr YTools::LexerOption hexNumbers = YTools::Option_Never;
+  //   };
+  struct LexerDefaultPolicy
+  {
+    // The whitespace set, identifier characters, and single-char token mapping
+    // > Scanning uses the SIMD kernels while the whitespace and identifier sets match lexerCharacters
+    static constexpr YTools::LexerCharacterTable characters = lexerCharacters;
 
-    void SkipWhitespace()
-    {
-      while (!CompletedStream() && IsWhiteSpace(*charStream))
-      {
-        charStream++;
-      };
-    }
+    // Reads numbers as hexadecimal, including those starting with [a/A - f/F]
+    // > Option_Runtime uses the constructor's _useHex and NextToken's _expectHex
+    static constexpr YTools::LexerOption hexNumbers = Option_Runtime;
 
-    // Creates a string token of a defined length, ignoring the characters' types
-    // > Includes whitespace
-    // _count : Grabs this many characters as a string regardless of type
-    YTools::LexerToken Read(unsigned long long _count)
-    {
-      // Empty read
-      if (_count == 0)
-      {
-        return { Token_String, std::string(""), charStream, charStream };
-      }
+    // Returns whitespace as tokens, Option_Runtime uses _includeWhitespace
+    static constexpr YTools::LexerOption whitespaceTokens = Option_Runtime;
 
-      // Read =====
-      const char* stringBeginning = charStream;
-      unsigned int stringLength = 0;
+    // Comments =====
+    // Read as Token_Comment, checked before any other token. Empty disables the syntax
+    static constexpr std::string_view lineComment = ""; // Runs up to the next '\n'
+    static constexpr std::string_view blockCommentOpen = "";
+    static constexpr std::string_view blockCommentClose = "";
 
-      while (stringLength < _count && !CompletedStream())
-      {
-        charStream++;
-        stringLength++;
-      }
+    // Skips comments like whitespace instead of returning them
+    static constexpr bool dropComments = false;
 
-      return { Token_String,
-               std::string(stringBeginning, stringLength),
-               stringBeginning,
-               stringBeginning + stringLength - 1 };
-    }
+    // String literals =====
+    // Read as Token_StringLiteral, running to the next matching quote. Empty disables string literals
+    static constexpr std::string_view stringQuotes = "";
 
-    // Creates a string token of all characters up to the first instance of the key character
-    // > Does not include the key character in the token string
-    // > Includes whitespace
-    // _key : The character to stop at
-    YTools::LexerToken ReadTo(char _key)
-    {
-      const char* stringBeginning = charStream;
-      unsigned int stringLength = 0;
+    // Escapes the following character inside a string literal, '\0' for none
+    static constexpr char stringEscape = '\\';
+  };
 
-      while (*charStream != _key && !CompletedStream())
-      {
-        charStream++;
-        stringLength++;
-      }
+  // C-style comments and string literals : // line, /* block */, "double" and 'single' quotes with '\' escapes
+  struct LexerCStylePolicy : LexerDefaultPolicy
+  {
+    static constexpr std::string_view lineComment = "//";
+    static constexpr std::string_view blockCommentOpen = "/*";
+    static constexpr std::string_view blockCommentClose = "*/";
+    static constexpr std::string_view stringQuotes = "\"'";
+  };
 
-      return { Token_String,
-               std::string(stringBeginning, stringLength),
-               stringBeginning,
-               stringBeginning + stringLength - 1 };
-    }
+  // A precomputed set of key characters for ReadToFirst and ReadThroughFirst
+  // > Reuse one set across calls to avoid rebuilding it, lookups cost the same for any number of keys
+  // > Explicit, as each construction fills a 512 byte table
+  struct LexerKeySet
+  {
+    unsigned short indices[256] = {}; // (Index + 1) of each character's first instance in the keys, 0 if not a key
+    unsigned int count = 0; // Number of distinct key characters
+    char firstKey = 0;
 
-    // Creates a string token of all characters including the first instance of the key character
-    // > Includes whitespace
-    // _key : The character to stop at
-    YTools::LexerToken ReadThrough(char _key)
+    explicit constexpr LexerKeySet(std::string_view _keys)
     {
-      const char* stringBeginning = charStream;
-      unsigned int stringLength = 0;
-
-      while (*charStream != _key && !CompletedStream())
+      for (unsigned int i = 0; i < _keys.size() && i < 0xffff; i++)
       {
-        charStream++;
-        stringLength++;
+        unsigned short& index = indices[(unsigned char)_keys[i]];
+        if (index == 0)
+        {
+          index = (unsigned short)(i + 1);
+          count++;
+        }
       }
 
-      // Include the key character
-      charStream++;
-      stringLength++;
-
-      return { Token_String,
-               std::string(stringBeginning, stringLength),
-               stringBeginning,
-               stringBeginning + stringLength - 1 };
+      if (!_keys.empty())
+        firstKey = _keys[0];
     }
 
-    // Creates a string token of all characters through the first instance of the key string
-    // > Includes whitespace
-    // _key : The character to stop at
-    /*
-    YTools::LexerToken ReadThrough(const char* _key)
+    constexpr bool Contains(char _char) const
     {
-      const char* stringBeginning = charStream;
-      unsigned int stringLength = 0;
+      return indices[(unsigned char)_char] != 0;
+    }
 
-      YTools::LexerToken tmpToken;
+    // Returns the index of the character in the keys, or -1 if it is not a key
+    constexpr unsigned int IndexOf(char _char) const
+    {
+      return (unsigned int)indices[(unsigned char)_char] - 1;
+    }
+  };
 
-      while (!CompletedStream())
+  // A set of keywords hashed at compile time for GetTokenSetIndex and NextToken
+  // > Lookups hash at most 8 characters and compare against a single candidate, regardless of the keyword count
+  // > constexpr YTools::LexerKeywordSet<3> keywords({ "if", "else", "while" });
+  template <unsigned int Count>
+  struct LexerKeywordSet
+  {
+    static_assert(Count > 0 && Count < 0xffff, "LexerKeywordSet supports 1 to 65534 keywords");
+
+    // Hash-and-displace: keywords are grouped into buckets, each bucket stores the seed that places
+    //   all of its keywords into distinct empty slots
+    static constexpr unsigned int bucketCount = Count / 2 + 1;
+    static constexpr unsigned int slotCount = [] {
+      unsigned int size = 2;
+      while (size < Count * 2)
+        size <<= 1;
+      return size;
+    }();
+    static constexpr unsigned int maxSeed = 0xffff;
+
+    std::string_view keywords[Count] = {};
+    unsigned short seeds[bucketCount] = {};
+    unsigned short slots[slotCount] = {}; // (Index + 1) of the keyword in each slot, 0 if empty
+    bool perfect = true; // False if a bucket could not be placed, lookups then fall back to a linear search
+
+    constexpr LexerKeywordSet(const char* const (&_keywords)[Count])
+    {
+      unsigned long long hashes[Count] = {};
+      unsigned int bucketSizes[bucketCount] = {};
+      for (unsigned int i = 0; i < Count; i++)
       {
-        ReadTo(_key[0]);
+        keywords[i] = _keywords[i];
+        hashes[i] = Hash(keywords[i]);
+        bucketSizes[hashes[i] % bucketCount]++;
+      }
 
-        if (ExpectString(_key, &tmpToken))
-        {
-          stringLength = (tmpToken.start + tmpToken.string.size()) - stringBeginning;
-          break;
-        }
-        else
+      // Place the largest buckets first, while the table is still empty
+      unsigned int order[bucketCount] = {};
+      for (unsigned int i = 0; i < bucketCount; i++)
+        order[i] = i;
+      for (unsigned int i = 1; i < bucketCount; i++)
+      {
+        for (unsigned int j = i; j > 0 && bucketSizes[order[j]] > bucketSizes[order[j - 1]]; j--)
         {
-          Read(1);
+          unsigned int swap = order[j];
+          order[j] = order[j - 1];
+          order[j - 1] = swap;
         }
-
-        //charStream++;
-        //stringLength++;
       }
 
-      return { Token_String, std::string(stringBeginning, stringLength), stringBeginning };
+      for (unsigned int i = 0; i < bucketCount && bucketSizes[order[i]] > 0; i++)
+      {
+        if (!PlaceBucket(order[i], hashes))
+          perfect = false;
+      }
     }
-    */
 
-    // Creates a string token of all characters up to the first instance of any of the key characters
-    // > Does not include the key character in the token string
-    // > Includes whitespace
-    // Returns the index of the found key character, or -1 if none is found
-    // _keys : The characters to stop at
-    // _outToken (Optional) : The output string token
-    unsigned int ReadToFirst(const std::string _keys, YTools::LexerToken* _outToken = nullptr)
+    // Returns the index of the keyword, Count if the string is not a keyword
+    // > Duplicate keywords return the index of their first instance
+    constexpr unsigned int IndexOf(std::string_view _string) const
     {
-      const char* stringBeginning = charStream;
-      unsigned int stringLength = 0;
-
-      unsigned int keyFound = 0;
-      while (!keyFound && !CompletedStream())
+      if (!perfect)
       {
-        for (int i = 1; i <= _keys.size() && !keyFound; i++)
+        for (unsigned int i = 0; i < Count; i++)
         {
-          keyFound = i * (*charStream == _keys.c_str()[i - 1]);
+          if (keywords[i] == _string)
+            return i;
         }
-
-        charStream++;
-        stringLength++;
+        return Count;
       }
 
-      // Prevent an infinite loop when hitting the end of the string
-      if (keyFound) // != 0
+      unsigned long long hash = Hash(_string);
+      unsigned int index = slots[Slot(hash, seeds[hash % bucketCount])];
+      if (index == 0 || keywords[index - 1] != _string)
+        return Count;
+      return index - 1;
+    }
+
+    constexpr bool Contains(std::string_view _string) const
+    {
+      return IndexOf(_string) != Count;
+    }
+
+    // FNV-1a over the length and at most the first and last 4 characters
+    // > Bounded so a lookup never reads a long string twice, the final compare checks the rest
+    static constexpr unsigned long long Hash(std::string_view _string)
+    {
+      const size_t size = _string.size();
+      unsigned long long hash = (0xcbf29ce484222325ull ^ size) * 0x100000001b3ull;
+      for (size_t i = 0; i < size; i++)
       {
-        // Undo the key read
-        charStream--;
-        stringLength--;
+        if (i == 4 && size > 8)
+          i = size - 4;
+        hash ^= (unsigned char)_string[i];
+        hash *= 0x100000001b3ull;
       }
+      return hash;
+    }
 
-      *_outToken = { Token_String,
-                     std::string(stringBeginning, stringLength),
-                     stringBeginning,
-                     stringBeginning + stringLength - 1 };
-
-      return keyFound - 1;
+  private:
+    // Mixes the seed into the keyword's hash (splitmix64 finalizer)
+    static constexpr unsigned int Slot(unsigned long long _hash, unsigned int _seed)
+    {
+      unsigned long long mixed = _hash + (_seed + 1) * 0x9e3779b97f4a7c15ull;
+      mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ull;
+      mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+      mixed ^= mixed >> 31;
+      return (unsigned int)(mixed & (slotCount - 1));
     }
 
-    // Creates a string token of all characters including the first instance of any of the key characters
-    // > Does not include the key character in the token string
-    // > Includes whitespace
-    // Returns the index of the found key character, or -1 if none is found
-    // _keys : The characters to stop at
-    // _outToken (Optional) : The output string token
-    unsigned int ReadThroughFirst(const std::string _keys, YTools::LexerToken* _outToken = nullptr)
+    // Finds a seed that places every keyword in the bucket into an empty slot
+    // Returns false if no seed was found
+    constexpr bool PlaceBucket(unsigned int _bucket, const unsigned long long* _hashes)
     {
-      const char* stringBeginning = charStream;
-      unsigned int stringLength = 0;
+      unsigned int members[Count] = {};
+      unsigned int memberCount = 0;
+      for (unsigned int i = 0; i < Count; i++)
+      {
+        if (_hashes[i] % bucketCount != _bucket)
+          continue;
+
+        // Only the first instance of a duplicate keyword is placed
+        bool duplicate = false;
+        for (unsigned int j = 0; j < memberCount && !duplicate; j++)
+          duplicate = keywords[members[j]] == keywords[i];
+        if (!duplicate)
+          members[memberCount++] = i;
+      }
 
-      unsigned int keyFound = 0;
-      while (!keyFound && !CompletedStream())
+      for (unsigned int seed = 0; seed <= maxSeed; seed++)
       {
-        for (int i = 1; i <= _keys.size() && !keyFound; i++)
+        unsigned int placed[Count] = {};
+        bool fits = true;
+        for (unsigned int i = 0; i < memberCount && fits; i++)
         {
-          keyFound = i * (*charStream == _keys.c_str()[i - 1]);
+          placed[i] = Slot(_hashes[members[i]], seed);
+          fits = slots[placed[i]] == 0;
+          for (unsigned int j = 0; j < i && fits; j++)
+            fits = placed[j] != placed[i];
         }
 
-        charStream++;
-        stringLength++;
-      }
+        if (!fits)
+          continue;
 
-      *_outToken = { Token_String,
-                     std::string(stringBeginning, stringLength),
-                     stringBeginning,
-                     stringBeginning + stringLength - 1 };
+        seeds[_bucket] = (unsigned short)seed;
+        for (unsigned int i = 0; i < memberCount; i++)
+          slots[placed[i]] = (unsigned short)(members[i] + 1);
+        return true;
+      }
 
-      return keyFound - 1;
+      return false;
     }
+  };
 
-    //=========================
-    // Numbers
-    //=========================
+  //=========================
+  // Scanning kernels
+  //=========================
+  // Each kernel returns the first position in [_begin, _end) that ends the scan, or _end if there is none
+  // > Full blocks are only loaded while they fit before _end, the remainder is scanned one byte at a time
 
-    // Decimal =====
+  namespace LexerScan {
 
-    // Returns an unsigned int
-    unsigned int GetUIntFromToken(const YTools::LexerToken* _token)
+    inline unsigned int CountTrailingZeros(unsigned long long _mask)
     {
-      int offset = _token->string[0] == '-'; // Ignores negative sign if present
-      return (unsigned int)strtoul(_token->string.c_str() + offset, nullptr, 10);
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward64(&index, _mask);
+      return (unsigned int)index;
+#else
+      return (unsigned int)__builtin_ctzll(_mask);
+#endif
     }
 
-    // Returns a signed int
-    int GetIntFromToken(const YTools::LexerToken* _token)
+#if defined(YTOOLS_LEXER_AVX2)
+    struct Block
     {
-      return (int)strtol(_token->string.c_str(), nullptr, 10);
-    }
-
-    // Returns an unsigned long
-    unsigned long GetULongFromToken(const YTools::LexerToken* _token)
+      static constexpr long long size = 32;
+      static constexpr unsigned int bitsPerByte = 1;
+      static constexpr unsigned long long allBytes = 0xffffffffull;
+      __m256i value;
+
+      static Block Load(const char* _position) { return { _mm256_loadu_si256((const __m256i*)_position) }; }
+      Block Equal(char _char) const { return { _mm256_cmpeq_epi8(value, _mm256_set1_epi8(_char)) }; }
+      Block Lowercase() const { return { _mm256_or_si256(value, _mm256_set1_epi8(0x20)) }; }
+      Block operator|(const Block& _other) const { return { _mm256_or_si256(value, _other.value) }; }
+      unsigned long long Mask() const { return (unsigned int)_mm256_movemask_epi8(value); }
+
+      // Bytes within [_low, _high]
+      Block InRange(char _low, char _high) const
+      {
+        __m256i offset = _mm256_sub_epi8(value, _mm256_set1_epi8(_low));
+        __m256i over = _mm256_subs_epu8(offset, _mm256_set1_epi8((char)(_high - _low)));
+        return { _mm256_cmpeq_epi8(over, _mm256_setzero_si256()) };
+      }
+    };
+#elif defined(YTOOLS_LEXER_SSE2)
+    struct Block
     {
-      int offset = _token->string[0] == '-'; // Ignores negative sign if present
-      return strtoul(_token->string.c_str() + offset, nullptr, 10);
-    }
-
-    // Returns a signed long
-    long GetLongFromToken(const YTools::LexerToken* _token)
+      static constexpr long long size = 16;
+      static constexpr unsigned int bitsPerByte = 1;
+      static constexpr unsigned long long allBytes = 0xffffull;
+      __m128i value;
+
+      static Block Load(const char* _position) { return { _mm_loadu_si128((const __m128i*)_position) }; }
+      Block Equal(char _char) const { return { _mm_cmpeq_epi8(value, _mm_set1_epi8(_char)) }; }
+      Block Lowercase() const { return { _mm_or_si128(value, _mm_set1_epi8(0x20)) }; }
+      Block operator|(const Block& _other) const { return { _mm_or_si128(value, _other.value) }; }
+      unsigned long long Mask() const { return (unsigned int)_mm_movemask_epi8(value); }
+
+      // Bytes within [_low, _high]
+      Block InRange(char _low, char _high) const
+      {
+        __m128i offset = _mm_sub_epi8(value, _mm_set1_epi8(_low));
+        __m128i over = _mm_subs_epu8(offset, _mm_set1_epi8((char)(_high - _low)));
+        return { _mm_cmpeq_epi8(over, _mm_setzero_si128()) };
+      }
+    };
+#elif defined(YTOOLS_LEXER_NEON)
+    struct Block
     {
-      return strtol(_token->string.c_str(), nullptr, 10);
-    }
+      static constexpr long long size = 16;
+      static constexpr unsigned int bitsPerByte = 4;
+      static constexpr unsigned long long allBytes = ~0ull;
+      uint8x16_t value;
+
+      static Block Load(const char* _position) { return { vld1q_u8((const uint8_t*)_position) }; }
+      Block Equal(char _char) const { return { vceqq_u8(value, vdupq_n_u8((uint8_t)_char)) }; }
+      Block Lowercase() const { return { vorrq_u8(value, vdupq_n_u8(0x20)) }; }
+      Block operator|(const Block& _other) const { return { vorrq_u8(value, _other.value) }; }
+
+      // Narrows each byte's result to 4 bits
+      unsigned long long Mask() const
+      {
+        uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(value), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+      }
 
-    // Hex =====
+      // Bytes within [_low, _high]
+      Block InRange(char _low, char _high) const
+      {
+        uint8x16_t offset = vsubq_u8(value, vdupq_n_u8((uint8_t)_low));
+        return { vcleq_u8(offset, vdupq_n_u8((uint8_t)(_high - _low))) };
+      }
+    };
+#endif // SIMD Block
 
-    // Returns an unsigned int
-    unsigned int GetUIntFromHexToken(const YTools::LexerToken* _token)
+    // Returns the first byte that is not ' ', '\n', '\r', or '\t'
+    inline const char* SkipWhitespace(const char* _begin, const char* _end)
     {
-      const std::string& str = _token->string;
+      const char* position = _begin;
 
-      // Ignores negative sign if present
-      int offset = str[0] == '-';
-      // Ignores "0x" if present
-      offset += 2 * (str.size() > (2 + offset) && str[0 + offset] == '0' && str[1 + offset] == 'x');
+#if defined(YTOOLS_LEXER_AVX2) || defined(YTOOLS_LEXER_SSE2) || defined(YTOOLS_LEXER_NEON)
+      while (_end - position >= Block::size)
+      {
+        Block block = Block::Load(position);
+        Block match = block.Equal(' ') | block.Equal('\n') | block.Equal('\r') | block.Equal('\t');
+        unsigned long long mask = ~match.Mask() & Block::allBytes;
 
-      return (unsigned int)strtoul(_token->string.c_str() + offset, nullptr, 16);
-    }
+        if (mask)
+          return position + CountTrailingZeros(mask) / Block::bitsPerByte;
 
-    // Returns a signed int
-    int GetIntFromHexToken(const YTools::LexerToken* _token)
-    {
-      const std::string& str = _token->string;
+        position += Block::size;
+      }
+#endif // SIMD
 
-      // Ignores negative sign if present
-      int offset = str[0] == '-';
-      // Ignores "0x" if present
-      offset += 2 * (str.size() > (2 + offset) && str[0 + offset] == '0' && str[1 + offset] == 'x');
+      while (position < _end && (lexerCharacters[*position].flags & Char_Whitespace))
+      {
+        position++;
+      }
 
-      return (int)strtol(_token->string.c_str() + offset, nullptr, 16);
+      return position;
     }
 
-    // Returns an unsigned long
-    unsigned long GetULongFromHexToken(const YTools::LexerToken* _token)
+    // Returns the first byte that can not continue a string token
+    inline const char* SkipIdentifier(const char* _begin, const char* _end)
     {
-      const std::string& str = _token->string;
+      const char* position = _begin;
 
-      // Ignores negative sign if present
-      int offset = str[0] == '-';
-      // Ignores "0x" if present
-      offset += 2 * (str.size() > (2 + offset) && str[0 + offset] == '0' && str[1 + offset] == 'x');
+#if defined(YTOOLS_LEXER_AVX2) || defined(YTOOLS_LEXER_SSE2) || defined(YTOOLS_LEXER_NEON)
+      while (_end - position >= Block::size)
+      {
+        Block block = Block::Load(position);
+        Block match = block.Lowercase().InRange('a', 'z') | block.InRange('0', '9') |
+                      block.Equal('_') | block.Equal('-');
+        unsigned long long mask = ~match.Mask() & Block::allBytes;
+
+        if (mask)
+          return position + CountTrailingZeros(mask) / Block::bitsPerByte;
+
+        position += Block::size;
+      }
+#endif // SIMD
 
-      return strtoul(_token->string.c_str() + offset, nullptr, 16);
+      while (position < _end && (lexerCharacters[*position].flags & Char_Identifier))
+      {
+        position++;
+      }
+
+      return position;
     }
 
-    // Returns a signed long
-    long GetLongFromHexToken(const YTools::LexerToken* _token)
+    // Returns the first byte without any of the flags in the table
+    // > The scalar scan for character tables the SIMD kernels do not match
+    inline const char* SkipFlags(const char* _begin,
+                                 const char* _end,
+                                 const YTools::LexerCharacterTable& _table,
+                                 unsigned char _flags)
     {
-      const std::string& str = _token->string;
+      const char* position = _begin;
 
-      // Ignores negative sign if present
-      int offset = str[0] == '-';
-      // Ignores "0x" if present
-      offset += 2 * (str.size() > (2 + offset) && str[0 + offset] == '0' && str[1 + offset] == 'x');
+      while (position < _end && (_table[*position].flags & _flags))
+      {
+        position++;
+      }
 
-      return strtol(_token->string.c_str() + offset, nullptr, 16);
+      return position;
+    }
+
+    // Returns the first instance of the key character
+    inline const char* FindChar(const char* _begin, const char* _end, char _key)
+    {
+      const char* position = _begin;
+
+#if defined(YTOOLS_LEXER_AVX2) || defined(YTOOLS_LEXER_SSE2) || defined(YTOOLS_LEXER_NEON)
+      while (_end - position >= Block::size)
+      {
+        unsigned long long mask = Block::Load(position).Equal(_key).Mask();
+
+        if (mask)
+          return position + CountTrailingZeros(mask) / Block::bitsPerByte;
+
+        position += Block::size;
+      }
+#endif // SIMD
+
+      while (position < _end && *position != _key)
+      {
+        position++;
+      }
+
+      return position;
+    }
+
+    // Returns the first instance of either key character
+    inline const char* FindEither(const char* _begin, const char* _end, char _first, char _second)
+    {
+      const char* position = _begin;
+
+#if defined(YTOOLS_LEXER_AVX2) || defined(YTOOLS_LEXER_SSE2) || defined(YTOOLS_LEXER_NEON)
+      while (_end - position >= Block::size)
+      {
+        Block block = Block::Load(position);
+        unsigned long long mask = (block.Equal(_first) | block.Equal(_second)).Mask();
+
+        if (mask)
+          return position + CountTrailingZeros(mask) / Block::bitsPerByte;
+
+        position += Block::size;
+      }
+#endif // SIMD
+
+      while (position < _end && *position != _first && *position != _second)
+      {
+        position++;
+      }
+
+      return position;
+    }
+
+    // Returns the first instance of any character in the key set
+    inline const char* FindFirstOf(const char* _begin, const char* _end, const YTools::LexerKeySet& _keys)
+    {
+      if (_keys.count == 1)
+        return FindChar(_begin, _end, _keys.firstKey);
+
+      const char* position = _begin;
+
+      while (position < _end && !_keys.Contains(*position))
+      {
+        position++;
+      }
+
+      return position;
+    }
+
+  } // namespace LexerScan
+
+  //=========================
+  // File input
+  //=========================
+
+  // Maps a file into memory (read-only) so it can be lexed without first copying it into a buffer
+  // > The page cache is shared with any other process reading the file
+  // > Must outlive every lexer and LexerTokenView created from it
+  class LexerMappedFile
+  {
+  private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool isOpen = false;
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif // Platforms
+
+  public:
+    // _path : The file to map
+    explicit LexerMappedFile(const char* _path)
+    {
+      // Empty files can not be mapped, but are still lexed as an empty stream
+      static const char emptyFile[1] = { '\0' };
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+      file = CreateFileA(_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+        return;
+
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(file, &fileSize))
+      {
+        Close();
+        return;
+      }
+
+      if (fileSize.QuadPart == 0)
+      {
+        data = emptyFile;
+        isOpen = true;
+        return;
+      }
+
+      mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping == nullptr)
+      {
+        Close();
+        return;
+      }
+
+      data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if (data == nullptr)
+      {
+        Close();
+        return;
+      }
+
+      size = (size_t)fileSize.QuadPart;
+      isOpen = true;
+#else
+      int file = open(_path, O_RDONLY);
+      if (file < 0)
+        return;
+
+      struct stat fileInfo;
+      if (fstat(file, &fileInfo) != 0)
+      {
+        close(file);
+        return;
+      }
+
+      if (fileInfo.st_size == 0)
+      {
+        close(file);
+        data = emptyFile;
+        isOpen = true;
+        return;
+      }
+
+      void* view = mmap(nullptr, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+      close(file); // The mapping keeps its own reference to the file
+
+      if (view == MAP_FAILED)
+        return;
+
+      // The lexer reads front to back
+      madvise(view, (size_t)fileInfo.st_size, MADV_SEQUENTIAL);
+
+      data = (const char*)view;
+      size = (size_t)fileInfo.st_size;
+      isOpen = true;
+#endif // Platforms
+    }
+
+    explicit LexerMappedFile(const std::string& _path) : LexerMappedFile(_path.c_str())
+    {}
+
+    LexerMappedFile(const LexerMappedFile&) = delete;
+    LexerMappedFile& operator=(const LexerMappedFile&) = delete;
+
+    ~LexerMappedFile()
+    {
+      Close();
+    }
+
+    void Close()
+    {
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+      if (mapping != nullptr && data != nullptr)
+        UnmapViewOfFile(data);
+      if (mapping != nullptr)
+        CloseHandle(mapping);
+      if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+
+      mapping = nullptr;
+      file = INVALID_HANDLE_VALUE;
+#else
+      if (size > 0)
+        munmap((void*)data, size);
+#endif // Platforms
+
+      data = nullptr;
+      size = 0;
+      isOpen = false;
+    }
+
+    // Returns false if the file could not be opened or mapped
+    bool IsOpen() const
+    {
+      return isOpen;
+    }
+
+    const char* Data() const
+    {
+      return data;
+    }
+
+    size_t Size() const
+    {
+      return size;
+    }
+  };
+
+  //=========================
+  // Number parsing
+  //=========================
+  // Parses directly from a token's characters, no null-terminator, locale, or allocation required
+
+  namespace LexerParse {
+
+    // Returns the value of a digit in bases up to 16, or 16 if the character is not a digit
+    inline unsigned int DigitValue(char _char)
+    {
+      if (_char >= '0' && _char <= '9')
+        return (unsigned int)(_char - '0');
+
+      const char lower = (char)(_char | 0x20);
+      if (lower >= 'a' && lower <= 'f')
+        return (unsigned int)(lower - 'a' + 10);
+
+      return 16;
+    }
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define YTOOLS_LEXER_SWAR_DIGITS
+    // Returns true if all 8 bytes are '0' - '9'
+    inline bool IsEightDigits(unsigned long long _chunk)
+    {
+      return (((_chunk & 0xf0f0f0f0f0f0f0f0ull) |
+               (((_chunk + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4)) == 0x3333333333333333ull);
+    }
+
+    // Converts 8 ascii digits (first digit in the lowest byte) to their value with 3 multiplies
+    inline unsigned long long ParseEightDigits(unsigned long long _chunk)
+    {
+      _chunk = (_chunk & 0x0f0f0f0f0f0f0f0full) * 2561 >> 8;
+      _chunk = (_chunk & 0x00ff00ff00ff00ffull) * 6553601 >> 16;
+      return (_chunk & 0x0000ffff0000ffffull) * 42949672960001ull >> 32;
+    }
+#endif // Little endian
+
+    // Reads digits of the base from [_begin, _end) up to the first non-digit
+    // Returns the position after the last digit read
+    // _outValue : The value read, saturated at the maximum unsigned long long
+    // _outOverflow : Set to true if the value did not fit
+    inline const char* ParseUnsigned(const char* _begin,
+                                     const char* _end,
+                                     unsigned int _base,
+                                     unsigned long long* _outValue,
+                                     bool* _outOverflow)
+    {
+      const char* position = _begin;
+      unsigned long long value = 0;
+
+#if defined(YTOOLS_LEXER_SWAR_DIGITS)
+      // Long decimal runs 8 digits at a time while the result can not overflow
+      if (_base == 10)
+      {
+        const unsigned long long safeValue = ((std::numeric_limits<unsigned long long>::max)() - 99999999ull) / 100000000ull;
+        while (_end - position >= 8 && value <= safeValue)
+        {
+          unsigned long long chunk;
+          memcpy(&chunk, position, 8);
+          if (!IsEightDigits(chunk))
+            break;
+
+          value = value * 100000000ull + ParseEightDigits(chunk);
+          position += 8;
+        }
+      }
+#endif // YTOOLS_LEXER_SWAR_DIGITS
+
+      const unsigned long long maxValue = (std::numeric_limits<unsigned long long>::max)();
+      bool overflow = false;
+
+      while (position < _end)
+      {
+        unsigned int digit = DigitValue(*position);
+        if (digit >= _base)
+          break;
+
+        if (value > (maxValue - digit) / _base)
+        {
+          overflow = true;
+          value = maxValue;
+        }
+        else if (!overflow)
+        {
+          value = value * _base + digit;
+        }
+
+        position++;
+      }
+
+      *_outValue = value;
+      if (overflow)
+        *_outOverflow = true;
+
+      return position;
+    }
+
+    // Reads an optionally negative value
+    // _outValue : The value read, saturated at the limits of long long
+    // _outOverflow : Set to true if the value did not fit
+    inline const char* ParseSigned(const char* _begin,
+                                   const char* _end,
+                                   unsigned int _base,
+                                   long long* _outValue,
+                                   bool* _outOverflow)
+    {
+      const bool negative = _begin < _end && *_begin == '-';
+
+      unsigned long long magnitude;
+      bool overflow = false;
+      const char* position = ParseUnsigned(_begin + negative, _end, _base, &magnitude, &overflow);
+
+      const unsigned long long limit = (unsigned long long)(std::numeric_limits<long long>::max)() + negative;
+      if (overflow || magnitude > limit)
+      {
+        *_outOverflow = true;
+        magnitude = limit;
+      }
+
+      *_outValue = negative ? (long long)(0ull - magnitude) : (long long)magnitude;
+      return position;
+    }
+
+    // Exactly representable powers of ten for the fast paths
+    inline constexpr double doublePowers[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                               1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                               1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    inline constexpr float floatPowers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+    // The decimal digits of a floating point number, as mantissa * 10^exponent
+    struct DecimalNumber
+    {
+      unsigned long long mantissa = 0;
+      int exponent = 0;
+      bool negative = false;
+      bool truncated = false; // More than 19 significant digits, the mantissa is inexact
+      bool hex = false; // "0x" tag found, the mantissa is the exact value
+      bool fractional = false; // '.' or exponent found
+      bool hasExponent = false;
+      const char* end = nullptr; // The position after the last character read
+    };
+
+    // Reads [-]digits[.digits][(e|E)[+|-]digits] from [_begin, _end)
+    inline DecimalNumber ParseDecimal(const char* _begin, const char* _end)
+    {
+      DecimalNumber number;
+      const char* position = _begin;
+
+      number.negative = position < _end && *position == '-';
+      position += number.negative;
+
+      // Hex integers are floats too
+      if (_end - position > 2 && position[0] == '0' && position[1] == 'x')
+      {
+        bool overflow = false;
+        number.end = ParseUnsigned(position + 2, _end, 16, &number.mantissa, &overflow);
+        number.hex = true;
+        return number;
+      }
+
+      int significantDigits = 0;
+      bool anyDigits = false;
+      auto addDigit = [&](unsigned int _digit, bool _isFraction) {
+        anyDigits = true;
+        if (significantDigits < 19)
+        {
+          number.mantissa = number.mantissa * 10 + _digit;
+          significantDigits += (number.mantissa != 0); // Leading zeros are not significant
+          number.exponent -= _isFraction;
+        }
+        else
+        {
+          number.truncated |= (_digit != 0);
+          number.exponent += !_isFraction;
+        }
+      };
+
+      while (position < _end && *position >= '0' && *position <= '9')
+      {
+        addDigit((unsigned int)(*position - '0'), false);
+        position++;
+      }
+
+      if (position < _end && *position == '.')
+      {
+        number.fractional = true;
+        position++;
+        while (position < _end && *position >= '0' && *position <= '9')
+        {
+          addDigit((unsigned int)(*position - '0'), true);
+          position++;
+        }
+      }
+
+      if (!anyDigits)
+      {
+        number.end = _begin;
+        return number;
+      }
+
+      // Exponent =====
+      if (position < _end && (*position == 'e' || *position == 'E'))
+      {
+        const char* exponentPosition = position + 1;
+        bool negativeExponent = false;
+        if (exponentPosition < _end && (*exponentPosition == '-' || *exponentPosition == '+'))
+        {
+          negativeExponent = *exponentPosition == '-';
+          exponentPosition++;
+        }
+
+        if (exponentPosition < _end && *exponentPosition >= '0' && *exponentPosition <= '9')
+        {
+          int exponent = 0;
+          while (exponentPosition < _end && *exponentPosition >= '0' && *exponentPosition <= '9')
+          {
+            if (exponent < 100000)
+              exponent = exponent * 10 + (*exponentPosition - '0');
+            exponentPosition++;
+          }
+
+          number.exponent += negativeExponent ? -exponent : exponent;
+          number.fractional = true;
+          number.hasExponent = true;
+          position = exponentPosition;
+        }
+      }
+
+      number.end = position;
+      return number;
+    }
+
+    // Infinity or zero for the number in [_begin, _end), too large or too small for Type
+    // > Matches strtod's results out of range, whichever side the leading digit's power of ten is on
+    template <typename Type>
+    Type FloatOutOfRange(const char* _begin, const char* _end)
+    {
+      const bool negative = _begin < _end && *_begin == '-';
+      const char* position = _begin + negative;
+
+      // Power of ten of the leading non-zero digit, without the exponent
+      long long scale = -1;
+      bool seenPoint = false;
+      bool seenDigit = false;
+      for (; position < _end && *position != 'e' && *position != 'E'; position++)
+      {
+        if (*position == '.')
+          seenPoint = true;
+        else if (!seenPoint && (seenDigit || *position != '0'))
+        {
+          seenDigit = true;
+          scale++;
+        }
+        else if (seenPoint && !seenDigit)
+        {
+          if (*position == '0')
+            scale--;
+          else
+            seenDigit = true;
+        }
+      }
+
+      long long exponent = 0;
+      if (position < _end)
+      {
+        position++;
+        const bool negativeExponent = position < _end && *position == '-';
+        position += (position < _end && (*position == '-' || *position == '+'));
+        for (; position < _end && *position >= '0' && *position <= '9'; position++)
+        {
+          if (exponent < 1000000)
+            exponent = exponent * 10 + (*position - '0');
+        }
+        exponent = negativeExponent ? -exponent : exponent;
+      }
+
+      const Type value = (scale + exponent >= 0) ? std::numeric_limits<Type>::infinity() : (Type)0;
+      return negative ? -value : value;
+    }
+
+    // Correctly rounded conversion of [_begin, _end) for the numbers the fast path can not handle
+    template <typename Type>
+    Type ParseFloatExact(const char* _begin, const char* _end)
+    {
+      Type value = 0;
+
+#if defined(__cpp_lib_to_chars)
+      std::from_chars_result result = std::from_chars(_begin, _end, value);
+      if (result.ec == std::errc::result_out_of_range)
+        return FloatOutOfRange<Type>(_begin, _end);
+
+      return value;
+#else
+      // Without a floating from_chars, strtod reads the number with the locale's decimal point in place of '.'
+      char buffer[0x200];
+      size_t length = (size_t)(_end - _begin);
+      if (length >= sizeof(buffer))
+        length = sizeof(buffer) - 1;
+
+      memcpy(buffer, _begin, length);
+      buffer[length] = '\0';
+
+      const char point = *localeconv()->decimal_point;
+      if (point != '.')
+      {
+        char* decimal = (char*)memchr(buffer, '.', length);
+        if (decimal != nullptr)
+          *decimal = point;
+      }
+
+      if constexpr (sizeof(Type) == sizeof(float))
+        return strtof(buffer, nullptr);
+      else
+        return (Type)strtod(buffer, nullptr);
+#endif // __cpp_lib_to_chars
+    }
+
+    // Converts digits read by ParseDecimal from _begin, correctly rounded
+    // > Clinger's fast path when mantissa and power of ten are both exact floats, otherwise ParseFloatExact
+    template <typename Type>
+    Type ToFloatingPoint(const DecimalNumber& _number, const char* _begin)
+    {
+      if (_number.hex)
+      {
+        Type value = (Type)_number.mantissa;
+        return _number.negative ? -value : value;
+      }
+
+      constexpr bool isSingle = sizeof(Type) == sizeof(float);
+      constexpr unsigned long long maxMantissa = isSingle ? (1ull << 24) : (1ull << 53);
+      constexpr int maxExponent = isSingle ? 10 : 22;
+
+      if (_number.end == _begin)
+        return 0;
+
+      if (!_number.truncated &&
+          _number.mantissa <= maxMantissa &&
+          _number.exponent >= -maxExponent &&
+          _number.exponent <= maxExponent)
+      {
+        const int exponent = _number.exponent < 0 ? -_number.exponent : _number.exponent;
+        Type value = (Type)_number.mantissa;
+        Type power = isSingle ? (Type)floatPowers[exponent] : (Type)doublePowers[exponent];
+
+        value = (_number.exponent < 0) ? value / power : value * power;
+        return _number.negative ? -value : value;
+      }
+
+      return ParseFloatExact<Type>(_begin, _number.end);
+    }
+
+    // Reads a float from [_begin, _end), correctly rounded
+    template <typename Type>
+    Type ParseFloatingPoint(const char* _begin, const char* _end)
+    {
+      return ToFloatingPoint<Type>(ParseDecimal(_begin, _end), _begin);
+    }
+
+  } // namespace LexerParse
+
+  //=========================
+  // Locations
+  //=========================
+
+  // A 1-based line and byte column in a lexed string
+  struct LexerLocation
+  {
+    size_t line = 0;
+    size_t column = 0;
+  };
+
+  // The offset of every line in a string, to map positions to lines and columns
+  // > Built once in a single scan, each lookup is then a binary search
+  class LexerLineIndex
+  {
+  private:
+    std::vector<size_t> lineStarts; // Offset of each line's first byte, starting with 0 once built
+
+  public:
+    // Indexes the lines of the string, replacing any previous index
+    void Build(const char* _begin, size_t _size)
+    {
+      lineStarts.clear();
+      lineStarts.push_back(0);
+
+      const char* position = _begin;
+      const char* end = _begin + _size;
+
+#if defined(YTOOLS_LEXER_AVX2) || defined(YTOOLS_LEXER_SSE2) || defined(YTOOLS_LEXER_NEON)
+      // Every newline in a block is read from one mask
+      using LexerScan::Block;
+      while (end - position >= Block::size)
+      {
+        unsigned long long mask = Block::Load(position).Equal('\n').Mask();
+
+        while (mask)
+        {
+          unsigned int index = LexerScan::CountTrailingZeros(mask) / Block::bitsPerByte;
+          lineStarts.push_back((size_t)(position - _begin) + index + 1);
+          mask &= ~(((1ull << Block::bitsPerByte) - 1) << (index * Block::bitsPerByte));
+        }
+
+        position += Block::size;
+      }
+#endif // SIMD
+
+      for (; position < end; position++)
+      {
+        if (*position == '\n')
+          lineStarts.push_back((size_t)(position - _begin) + 1);
+      }
+    }
+
+    bool IsBuilt() const
+    {
+      return !lineStarts.empty();
+    }
+
+    // Returns the number of lines, 0 if the index has not been built
+    size_t LineCount() const
+    {
+      return lineStarts.size();
+    }
+
+    // Returns the line and column of the byte at the offset
+    // > The index must be built
+    YTools::LexerLocation Locate(size_t _offset) const
+    {
+      // The last line starting at or before the offset
+      size_t low = 0;
+      size_t high = lineStarts.size();
+      while (high - low > 1)
+      {
+        size_t middle = low + (high - low) / 2;
+        if (lineStarts[middle] <= _offset)
+          low = middle;
+        else
+          high = middle;
+      }
+
+      return { low + 1, _offset - lineStarts[low] + 1 };
+    }
+  };
+
+  // TokenString : std::string to own a copy of the characters
+  // > std::string_view to point into the lexer's source buffer without allocating
+  template <typename TokenString>
+  struct BasicLexerToken
+  {
+    YTools::TokenTypes type{};
+    TokenString string{};
+    const char* start = 0;
+    const char* end = 0;
+  };
+
+  using LexerToken = BasicLexerToken<std::string>;
+  using LexerTokenView = BasicLexerToken<std::string_view>; // Only valid while the source buffer is alive
+  using LexerTokenPmr = BasicLexerToken<std::pmr::string>; // Allocated from the lexer's memory resource
+
+  // Flat structure-of-arrays token storage, filled by TokenizeBatch and TokenizeAll
+  // > Offsets are relative to the start of the lexer's source, larger sources than maxSourceSize are not batched
+  // > Clear() keeps the arrays' capacity, reuse one batch between files to avoid allocating
+  // > The arrays can be allocated from a std::pmr::memory_resource, such as the one backing the lexer's tokens
+  struct LexerTokenBatch
+  {
+    static constexpr size_t maxSourceSize = 0xFFFFFFFF; // Every offset and length fits in 32 bits
+
+    std::pmr::vector<YTools::TokenTypes> types;
+    std::pmr::vector<uint32_t> offsets;
+    std::pmr::vector<uint32_t> lengths;
+
+    LexerTokenBatch(std::pmr::memory_resource* _resource = std::pmr::get_default_resource()) : types(_resource),
+                                                                                                 offsets(_resource),
+                                                                                                 lengths(_resource)
+    {}
+
+    size_t Size() const
+    {
+      return types.size();
+    }
+
+    void Clear()
+    {
+      types.clear();
+      offsets.clear();
+      lengths.clear();
+    }
+
+    void Reserve(size_t _count)
+    {
+      types.reserve(_count);
+      offsets.reserve(_count);
+      lengths.reserve(_count);
+    }
+
+    void Push(YTools::TokenTypes _type, uint32_t _offset, uint32_t _length)
+    {
+      types.push_back(_type);
+      offsets.push_back(_offset);
+      lengths.push_back(_length);
+    }
+  };
+
+  // An edit to a lexed string, see BasicLexer::RelexEdit
+  struct LexerEdit
+  {
+    uint32_t offset = 0; // Where the edit starts
+    uint32_t removed = 0; // Bytes removed from the string at the offset
+    uint32_t inserted = 0; // Bytes inserted in their place
+  };
+
+  // The tokens RelexEdit replaced in a batch
+  struct LexerRelexRange
+  {
+    size_t first = 0; // Index of the first re-lexed token
+    size_t count = 0; // Number of re-lexed tokens in the updated batch
+    size_t replaced = 0; // Number of tokens they replaced
+  };
+
+  // A number token and its value, read in a single pass by NextNumber
+  struct LexerNumber
+  {
+    YTools::TokenTypes type = Token_Unknown; // Token_Decimal, Token_Hex, or Token_Float
+    long long integer = 0; // Token_Decimal and Token_Hex, saturated (Hex is the bit pattern, ignoring sign)
+    double real = 0; // All types, correctly rounded
+    bool overflow = false; // The integer did not fit, and was saturated
+    const char* start = 0;
+    const char* end = 0;
+  };
+
+  // A saved read position, see BasicLexer::Checkpoint
+  // > Only valid for the lexer that created it
+  // > Does not hold tokens, backtracking re-lexes the tokens it moves back over
+  struct LexerCheckpoint
+  {
+    const char* head = 0;
+  };
+
+  //=========================
+  // Statistics
+  //=========================
+  // Counts of the work a lexer did, kept only when YTOOLS_LEXER_STATS is defined, see BasicLexer::GetStats
+  // > Counts work rather than results, a token lexed again after a backtrack is counted again
+
+  constexpr unsigned int lexerTokenTypeCount = Token_StringLiteral + 2; // Token_End through Token_StringLiteral
+
+  inline const char* GetTokenTypeName(TokenTypes _type)
+  {
+    static const char* const names[] = {
+      "End", "Unknown", "String", "Float", "Decimal", "Hex",
+      "Hyphen", "Comma", "LeftBracket", "RightBracket", "LeftBrace", "RightBrace", "LeftParen", "RightParen",
+      "FwdSlash", "LessThan", "GreaterThan", "Equal", "Plus", "Star", "BackSlash", "Pound", "Period",
+      "SemiColon", "Colon", "Apostrophe", "Quote", "Pipe",
+      "NullTerminator", "Whitespace", "Comment", "StringLiteral"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == lexerTokenTypeCount, "Every token type needs a name");
+
+    return names[_type + 1];
+  }
+
+  struct LexerStats
+  {
+    unsigned long long tokens[lexerTokenTypeCount] = {}; // Tokens lexed, indexed by type + 1, see TokenCount
+    unsigned long long whitespaceBytes = 0;        // Skipped before tokens and expectations
+    unsigned long long lookaheadHits = 0;          // Tokens taken from the PeekToken cache instead of being lexed
+    unsigned long long expectStringBacktracks = 0; // Failed ExpectString calls
+    unsigned long long expectTypeBacktracks = 0;   // Failed ExpectType calls
+    unsigned long long restores = 0;               // Restore calls, including uncommitted Speculations
+    unsigned long long batchNanoseconds = 0;       // Time spent in TokenizeBatch, TokenizeParallel, and RelexEdit
+
+    unsigned long long TokenCount(TokenTypes _type) const
+    {
+      return tokens[_type + 1];
+    }
+
+    unsigned long long TotalTokens() const
+    {
+      unsigned long long total = 0;
+      for (unsigned long long count : tokens)
+      {
+        total += count;
+      }
+      return total;
+    }
+
+    void Add(const LexerStats& _other)
+    {
+      for (unsigned int i = 0; i < lexerTokenTypeCount; i++)
+      {
+        tokens[i] += _other.tokens[i];
+      }
+
+      whitespaceBytes += _other.whitespaceBytes;
+      lookaheadHits += _other.lookaheadHits;
+      expectStringBacktracks += _other.expectStringBacktracks;
+      expectTypeBacktracks += _other.expectTypeBacktracks;
+      restores += _other.restores;
+      batchNanoseconds += _other.batchNanoseconds;
+    }
+
+#if defined(YTOOLS_LEXER_STATS)
+    // Writes the counts through the Ytools logger, as two lines
+    // _type (Optional) : The message type written as, must pass the logger's level filters to appear
+    void Log(Ytools::LogTypes _type = Ytools::Log_Type_Info) const
+    {
+      Ytools::LoggerAssembleLine(_type,
+                                 "[Lexer] %llu tokens, %llu whitespace bytes, %llu lookahead hits, "
+                                 "%llu ExpectString and %llu ExpectType backtracks, %llu restores, %.3f ms in batches",
+                                 TotalTokens(), whitespaceBytes, lookaheadHits,
+                                 expectStringBacktracks, expectTypeBacktracks, restores, batchNanoseconds / 1e6);
+
+      // Token types =====
+      char text[0x400];
+      int length = snprintf(text, sizeof(text), "[Lexer] Tokens :");
+      for (unsigned int i = 0; i < lexerTokenTypeCount && length > 0 && (size_t)length < sizeof(text); i++)
+      {
+        if (tokens[i] > 0)
+          length += snprintf(text + length, sizeof(text) - length, " %s %llu", GetTokenTypeName((TokenTypes)((int)i - 1)), tokens[i]);
+      }
+
+      Ytools::LoggerAssembleLine(_type, "%s", text);
+    }
+#endif // YTOOLS_LEXER_STATS
+  };
+
+  // Adds the time from construction to destruction to a counter
+  // > { YTools::LexerScopedTimer timer(parseNanoseconds); Parse(lexer); }
+  class LexerScopedTimer
+  {
+  public:
+    LexerScopedTimer(unsigned long long& _outNanoseconds) : target(_outNanoseconds),
+                                                            start(std::chrono::steady_clock::now())
+    {}
+
+    ~LexerScopedTimer()
+    {
+      target += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    LexerScopedTimer(const LexerScopedTimer&) = delete;
+    LexerScopedTimer& operator=(const LexerScopedTimer&) = delete;
+
+  private:
+    unsigned long long& target;
+    const std::chrono::steady_clock::time_point start;
+  };
+
+  class LexerStream;
+
+  template <typename TokenString = std::string, typename Policy = YTools::LexerDefaultPolicy>
+  class BasicLexer
+  {
+  public:
+    using Token = YTools::BasicLexerToken<TokenString>;
+
+    // The most bytes the lexer inspects beyond the first byte after a token to decide where the token ends
+    // > ('e', sign, digit) after a number, or the rest of a comment opener that did not match
+    static constexpr size_t tokenLookahead = [] {
+      size_t lookahead = 2;
+      if (Policy::lineComment.size() > lookahead)
+        lookahead = Policy::lineComment.size();
+      if (Policy::blockCommentOpen.size() > lookahead)
+        lookahead = Policy::blockCommentOpen.size();
+      return lookahead;
+    }();
+
+    static_assert(Policy::blockCommentOpen.empty() || !Policy::blockCommentClose.empty(),
+                  "Block comments need a closing delimiter");
+
+    // The most tokens LookAhead holds at once
+    static constexpr size_t lookaheadCapacity = 8;
+
+  private:
+    friend class YTools::LexerStream; // Lexes each buffered window and reads back the head
+    template <typename, typename> friend class BasicLexer; // Batches are lexed through a view lexer sharing the head
+
+
+    const char* charStream; // The string to be read from 
+    const char* const streamStart; // Used in GetProgress
+    const char* const streamEnd; // Used to avoid requiring \0 at the end of the string
+    const bool usesHex; // Defines how number identification handles a,b,c,d,e,f,A,B,C,D,E,F
+
+    // Lookahead ring =====
+    // The next tokens in order, keyed by the head the first was read from
+    // > The source does not change, so the tokens stay valid while the head is there
+    std::optional<Token> lookahead[lookaheadCapacity]; // Emplaced so a token keeps its string's memory resource
+    const char* lookaheadEnds[lookaheadCapacity] = {}; // The head after each token
+    size_t lookaheadFirst = 0; // Ring index of the next token
+    size_t lookaheadCount = 0;
+    const char* lookaheadHead = nullptr; // The head the first token was read from, nullptr when empty
+
+    YTools::LexerLineIndex lineIndex; // Built by the first GetLocation call
+
+    std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource(); // See SetMemoryResource
+
+#if defined(YTOOLS_LEXER_STATS)
+    YTools::LexerStats stats;
+#endif // YTOOLS_LEXER_STATS
+
+  public:
+    BasicLexer(const char* _str, size_t _size, bool _useHex = false) : charStream(_str),
+                                                                       streamStart(_str),
+                                                                       streamEnd(streamStart + _size - 1),
+                                                                       usesHex(_useHex)
+    {}
+
+    BasicLexer(const std::vector<char>& _str, bool _useHex = false) : charStream(_str.data()),
+                                                                      streamStart(_str.data()),
+                                                                      streamEnd(streamStart + _str.size() - 1),
+                                                                      usesHex(_useHex)
+    {}
+
+    BasicLexer(const std::string& _str, bool _useHex = false) : charStream(_str.data()),
+                                                                streamStart(_str.data()),
+                                                                streamEnd(streamStart + _str.size() - 1),
+                                                                usesHex(_useHex)
+    {}
+
+    // Lexes the mapped file in place
+    // > The file must stay mapped while the lexer is in use
+    BasicLexer(const YTools::LexerMappedFile& _file, bool _useHex = false) : charStream(_file.Data()),
+                                                                             streamStart(_file.Data()),
+                                                                             streamEnd(streamStart + _file.Size() - 1),
+                                                                             usesHex(_useHex)
+    {}
+
+    // A temporary mapping is unmapped before the lexer could read it
+    BasicLexer(YTools::LexerMappedFile&&, bool _useHex = false) = delete;
+
+    // Allocates token strings from the resource, when TokenString is std::pmr::string
+    // > A std::pmr::monotonic_buffer_resource keeps a parse's tokens contiguous and frees them all at once
+    // > The resource must outlive every token created from it, including tokens output through _outToken parameters
+    void SetMemoryResource(std::pmr::memory_resource* _resource)
+    {
+      memoryResource = _resource;
+      lookaheadHead = nullptr;
+    }
+
+#if defined(YTOOLS_LEXER_STATS)
+    // The work counted since construction or the last ResetStats
+    // > Only available when YTOOLS_LEXER_STATS is defined
+    const YTools::LexerStats& GetStats() const
+    {
+      return stats;
+    }
+
+    void ResetStats()
+    {
+      stats = {};
+    }
+#endif // YTOOLS_LEXER_STATS
+
+    //=========================
+    // Token retrieval
+    //=========================
+
+    // Returns a token containing the string up to the next whitespace character
+    // _expectHex (Optional) : overrides [a/A - f/F] as numeric values at the start of a token
+    // _includeWhitespace (Optional) : Will treat whitespace as tokens when true
+    Token NextToken(bool _expectHex = false, bool _includeWhitespace = false)
+    {
+      // Consume the token read by PeekToken or LookAhead
+      if (lookaheadHead == charStream &&
+          ExpectsHex(_expectHex) == ExpectsHex(false) &&
+          IncludesWhitespace(_includeWhitespace) == IncludesWhitespace(false))
+      {
+        YTOOLS_LEXER_STAT(stats.lookaheadHits++);
+        const size_t slot = lookaheadFirst;
+        PopLookahead(); // The popped slot is only overwritten by the next fill
+        return std::move(*lookahead[slot]);
+      }
+
+#if defined(YTOOLS_LEXER_STATS)
+      Token token = LexToken(_expectHex, _includeWhitespace);
+      stats.tokens[token.type + 1]++;
+      return token;
+#else
+      return LexToken(_expectHex, _includeWhitespace);
+#endif // YTOOLS_LEXER_STATS
+    }
+
+  private:
+    // Lexes tokens into the lookahead ring until it holds at least _k + 1
+    void FillLookahead(size_t _k)
+    {
+      // Held tokens only follow from the head they were read from
+      if (lookaheadHead != charStream)
+      {
+        lookaheadFirst = 0;
+        lookaheadCount = 0;
+      }
+
+      const char* head = charStream;
+      if (lookaheadCount > 0)
+        charStream = lookaheadEnds[(lookaheadFirst + lookaheadCount - 1) % lookaheadCapacity];
+
+      // Cleared so NextToken lexes rather than consuming the ring
+      lookaheadHead = nullptr;
+      while (lookaheadCount <= _k)
+      {
+        const size_t slot = (lookaheadFirst + lookaheadCount) % lookaheadCapacity;
+        lookahead[slot].emplace(NextToken());
+        lookaheadEnds[slot] = charStream;
+        lookaheadCount++;
+      }
+
+      charStream = head;
+      lookaheadHead = head;
+    }
+
+    // Moves past the first token of the lookahead ring
+    void PopLookahead()
+    {
+      charStream = lookaheadEnds[lookaheadFirst];
+      lookaheadFirst = (lookaheadFirst + 1) % lookaheadCapacity;
+      lookaheadCount--;
+      lookaheadHead = (lookaheadCount > 0) ? charStream : nullptr;
+    }
+
+    // Moves past the characters read before a token, whitespace and comments the policy drops
+    // > Shared by every read that skips to the next token, so they all start where NextToken does
+    // _keepWhitespace : Stops at whitespace, for whitespace tokens
+    void SkipIgnored(bool _keepWhitespace)
+    {
+      if (!_keepWhitespace)
+        SkipWhitespace();
+
+      if constexpr (hasComments && Policy::dropComments)
+      {
+        const char* commentEnd;
+        while (!CompletedStream() && (commentEnd = SkipComment(charStream)) != nullptr)
+        {
+          charStream = commentEnd;
+          if (!_keepWhitespace)
+            SkipWhitespace();
+        }
+      }
+    }
+
+    // Reads the next token from the stream, see NextToken
+    Token LexToken(bool _expectHex, bool _includeWhitespace)
+    {
+      SkipIgnored(IncludesWhitespace(_includeWhitespace));
+
+      // Comments =====
+      if constexpr (hasComments && !Policy::dropComments)
+      {
+        const char* commentEnd;
+        if (!CompletedStream() && (commentEnd = SkipComment(charStream)) != nullptr)
+          return GetSpanToken(Token_Comment, commentEnd);
+      }
+
+      if (CompletedStream())
+      {
+        return { Token_End, MakeTokenString(charStream, 0), charStream, charStream };
+      }
+
+      // Get token =====
+      if constexpr (hasStringLiterals)
+      {
+        if (quoteKeys.Contains(*charStream))
+          return GetSpanToken(Token_StringLiteral, SkipStringLiteral(charStream));
+      }
+
+      const YTools::LexerCharacter& character = Policy::characters[*charStream];
+
+      if (character.flags & Char_NumberStart)
+        return GetNumberToken(UsesHex());
+
+      // Overrides [a/A - f/F] as numeric values
+      if (ExpectsHex(_expectHex) && (character.flags & Char_Hex))
+        return GetNumberToken(true);
+
+      if (character.flags & Char_IdentifierStart)
+        return GetStringToken();
+
+      // The whitespace skip prevents this from being called when _includeWhitespace is false
+      if (character.flags & Char_Whitespace)
+        return GetWhitespaceToken();
+
+      return GetSingleCharToken(character.type);
+    }
+
+  public:
+    // Returns the next token as NextToken does, and matches string tokens against the keyword set
+    // _keywords : The compile-time keyword set to look string tokens up in
+    // _outIndex : Output for the keyword's index, Count if the token is not a keyword
+    template <unsigned int Count>
+    Token NextToken(const YTools::LexerKeywordSet<Count>& _keywords,
+                    unsigned int* _outIndex,
+                    bool _expectHex = false,
+                    bool _includeWhitespace = false)
+    {
+      Token token = NextToken(_expectHex, _includeWhitespace);
+
+      // Looked up on the source span once the token is lexed, the scan stays vectorized
+      // > Only the bounded hash and one candidate compare touch the identifier again
+      if (token.type == Token_String)
+        *_outIndex = _keywords.IndexOf(std::string_view(token.start, token.end - token.start + 1));
+      else
+        *_outIndex = Count;
+
+      return token;
+    }
+
+    // Reads the next token and compares it with the given string
+    // Returns true and outputs the read token if they match
+    // Returns false if they do not match, Does not move forward in the read string
+    // > Compares in place against the stream, a token is only created for _outToken
+    // _expected : The string to compare against
+    // _outToken (Optional) : Output for the read expected string if found
+    bool ExpectString(std::string_view _expected, Token* _outToken = nullptr)
+    {
+      const char* prevCharHead = charStream;
+
+      if (_expected.empty() || !IsWhiteSpace(_expected[0]))
+        SkipIgnored(false);
+
+      size_t remaining = CompletedStream() ? 0 : (size_t)(streamEnd + 1 - charStream);
+
+      if (_expected.size() <= remaining && memcmp(charStream, _expected.data(), _expected.size()) == 0)
+      {
+        if (_outToken != nullptr)
+          OutputToken(_outToken, Read(_expected.size()));
+        else
+          charStream += _expected.size();
+
+        return true;
+      }
+
+      // Undo whitespace skip
+      charStream = prevCharHead;
+      YTOOLS_LEXER_STAT(stats.expectStringBacktracks++);
+      return false;
+    }
+
+    // Reads the next token and compares its type with the given type
+    // Returns true and outputs the token if they match
+    // Returns false if they do not match, Does not move forward in the read string
+    // _expected : The type to compare against
+    // _outToken (Optional) : Output for the read string if the types match
+    bool ExpectType(YTools::TokenTypes _expected, Token* _outToken = nullptr)
+    {
+      // Matched against the cached lookahead, a failed match keeps it for the next expectation
+      if (_expected != Token_Whitespace && _expected != Token_Hex && !IncludesWhitespace(false))
+      {
+        if (PeekToken().type != _expected)
+        {
+          YTOOLS_LEXER_STAT(stats.expectTypeBacktracks++);
+          return false;
+        }
+
+        if (_outToken != nullptr)
+          OutputToken(_outToken, NextToken());
+        else
+          PopLookahead();
+
+        return true;
+      }
+
+      const char* prevCharHead = charStream;
+
+      if (_expected != Token_Whitespace)
+        SkipWhitespace();
+
+      Token next = NextToken(_expected == Token_Hex);
+
+      if (next.type == _expected)
+      {
+        if (_outToken != nullptr)
+          OutputToken(_outToken, std::move(next));
+
+        return true;
+      }
+
+      // Undo token read
+      charStream = prevCharHead;
+      YTOOLS_LEXER_STAT(stats.expectTypeBacktracks++);
+      return false;
+    }
+
+    void SkipWhitespace()
+    {
+      YTOOLS_LEXER_STAT(const char* skipStart = charStream);
+      charStream = ScanWhitespace(charStream);
+      YTOOLS_LEXER_STAT(stats.whitespaceBytes += (unsigned long long)(charStream - skipStart));
+    }
+
+    // Creates a string token of a defined length, ignoring the characters' types
+    // > Includes whitespace
+    // _count : Grabs this many characters as a string regardless of type
+    Token Read(unsigned long long _count)
+    {
+      // Empty read
+      if (_count == 0)
+      {
+        return { Token_String, MakeTokenString(charStream, 0), charStream, charStream };
+      }
+
+      // Read =====
+      const char* stringBeginning = charStream;
+      unsigned int stringLength = 0;
+
+      while (stringLength < _count && !CompletedStream())
+      {
+        charStream++;
+        stringLength++;
+      }
+
+      return { Token_String,
+               MakeTokenString(stringBeginning, stringLength),
+               stringBeginning,
+               stringBeginning + stringLength - 1 };
+    }
+
+    // Creates a string token of all characters up to the first instance of the key character
+    // > Does not include the key character in the token string
+    // > Includes whitespace
+    // _key : The character to stop at
+    Token ReadTo(char _key)
+    {
+      const char* stringBeginning = charStream;
+      unsigned int stringLength = 0;
+
+      charStream = LexerScan::FindChar(charStream, streamEnd + 1, _key);
+      stringLength = (unsigned int)(charStream - stringBeginning);
+
+      return { Token_String,
+               MakeTokenString(stringBeginning, stringLength),
+               stringBeginning,
+               stringBeginning + stringLength - 1 };
+    }
+
+    // Creates a string token of all characters including the first instance of the key character
+    // > Includes whitespace
+    // _key : The character to stop at
+    Token ReadThrough(char _key)
+    {
+      const char* stringBeginning = charStream;
+      unsigned int stringLength = 0;
+
+      charStream = LexerScan::FindChar(charStream, streamEnd + 1, _key);
+      stringLength = (unsigned int)(charStream - stringBeginning);
+
+      // Include the key character, if it was found before the end of the stream
+      if (!CompletedStream())
+      {
+        charStream++;
+        stringLength++;
+      }
+
+      return { Token_String,
+               MakeTokenString(stringBeginning, stringLength),
+               stringBeginning,
+               stringBeginning + stringLength - 1 };
+    }
+
+    // Creates a string token of all characters through the first instance of the key string
+    // > Includes whitespace
+    // > Reads to the end of the stream if the key is not found
+    // _key : The string to stop after
+    Token ReadThrough(std::string_view _key)
+    {
+      if (_key.empty())
+        return Read(0);
+
+      return GetSpanToken(Token_String, FindThrough(charStream, _key));
+    }
+
+    // Creates a string token of all characters up to the first instance of any of the key characters
+    // > Does not include the key character in the token string
+    // > Includes whitespace
+    // Returns the index of the found key character, or -1 if none is found
+    // _keys : The characters to stop at
+    // _outToken (Optional) : The output string token
+    unsigned int ReadToFirst(const YTools::LexerKeySet& _keys, Token* _outToken = nullptr)
+    {
+      const char* stringBeginning = charStream;
+
+      charStream = LexerScan::FindFirstOf(charStream, streamEnd + 1, _keys);
+      unsigned int stringLength = (unsigned int)(charStream - stringBeginning);
+
+      unsigned int keyFound = CompletedStream() ? -1 : _keys.IndexOf(*charStream);
+
+      if (_outToken != nullptr)
+      {
+        OutputToken(_outToken,
+                    { Token_String,
+                      MakeTokenString(stringBeginning, stringLength),
+                      stringBeginning,
+                      stringBeginning + stringLength - 1 });
+      }
+
+      return keyFound;
+    }
+
+    // Searches for one or two keys directly, more build a LexerKeySet for the call
+    // > Prefer reusing a LexerKeySet in loops over more than two keys
+    unsigned int ReadToFirst(std::string_view _keys, Token* _outToken = nullptr)
+    {
+      if (_keys.size() > 2)
+        return ReadToFirst(YTools::LexerKeySet(_keys), _outToken);
+
+      return ReadToFewKeys(_keys, false, _outToken);
+    }
+
+    // Creates a string token of all characters including the first instance of any of the key characters
+    // > Includes whitespace
+    // Returns the index of the found key character, or -1 if none is found
+    // _keys : The characters to stop at
+    // _outToken (Optional) : The output string token
+    unsigned int ReadThroughFirst(const YTools::LexerKeySet& _keys, Token* _outToken = nullptr)
+    {
+      const char* stringBeginning = charStream;
+
+      charStream = LexerScan::FindFirstOf(charStream, streamEnd + 1, _keys);
+
+      unsigned int keyFound = -1;
+      if (!CompletedStream())
+      {
+        // Include the key character
+        keyFound = _keys.IndexOf(*charStream);
+        charStream++;
+      }
+
+      unsigned int stringLength = (unsigned int)(charStream - stringBeginning);
+
+      if (_outToken != nullptr)
+      {
+        OutputToken(_outToken,
+                    { Token_String,
+                      MakeTokenString(stringBeginning, stringLength),
+                      stringBeginning,
+                      stringBeginning + stringLength - 1 });
+      }
+
+      return keyFound;
+    }
+
+    // Searches for one or two keys directly, more build a LexerKeySet for the call
+    // > Prefer reusing a LexerKeySet in loops over more than two keys
+    unsigned int ReadThroughFirst(std::string_view _keys, Token* _outToken = nullptr)
+    {
+      if (_keys.size() > 2)
+        return ReadThroughFirst(YTools::LexerKeySet(_keys), _outToken);
+
+      return ReadToFewKeys(_keys, true, _outToken);
+    }
+
+    // Reads the next token as a number, parsing its value in the same pass as finding its end
+    // > Reads the same characters NextToken would, without creating a token string
+    // Returns true and outputs the number if the next token is a number
+    // Returns false if it is not, Does not move forward in the read string
+    // _outNumber : Output for the number and its value
+    // _expectHex (Optional) : See NextToken
+    bool NextNumber(YTools::LexerNumber* _outNumber, bool _expectHex = false)
+    {
+      const char* prevCharHead = charStream;
+
+      SkipIgnored(false);
+
+      const char* begin = charStream;
+      const char* end = streamEnd + 1;
+
+      if (CompletedStream())
+      {
+        charStream = prevCharHead;
+        return false;
+      }
+
+      const unsigned char flags = Policy::characters[*begin].flags;
+      const bool isHexStart = ExpectsHex(_expectHex) && (flags & Char_Hex) && !(flags & Char_NumberStart);
+      const bool isHyphenOnly = *begin == '-' && (begin + 1 >= end || !IsNumber(*(begin + 1)));
+
+      if ((!(flags & Char_NumberStart) && !isHexStart) || isHyphenOnly)
+      {
+        charStream = prevCharHead;
+        return false;
+      }
+
+      YTools::LexerNumber number;
+      number.start = begin;
+
+      const char* digits = begin + (*begin == '-');
+      const bool hexTag = digits + 1 < end && digits[0] == '0' && digits[1] == 'x';
+
+      if (isHexStart || UsesHex() || hexTag)
+      {
+        // Hex =====
+        unsigned long long value;
+        charStream = LexerParse::ParseUnsigned(digits + 2 * (hexTag && !isHexStart && !UsesHex()), end, 16, &value, &number.overflow);
+
+        number.type = Token_Hex;
+        number.integer = (long long)value;
+        number.real = (double)value;
+      }
+      else
+      {
+        // Decimal and float =====
+        LexerParse::DecimalNumber decimal = LexerParse::ParseDecimal(begin, end);
+        charStream = decimal.end;
+
+        // No digits ("-."), only the sign was part of a value
+        if (charStream == begin)
+          charStream = digits;
+
+        // Repeated periods continue the token, as in NextToken, but are not part of the value
+        if (!decimal.hasExponent && !CompletedStream() && IsNumber(*charStream))
+        {
+          while (!CompletedStream() && IsNumber(*charStream))
+          {
+            charStream++;
+          }
+
+          SkipExponent();
+          decimal.fractional = true;
+        }
+
+        number.real = LexerParse::ToFloatingPoint<double>(decimal, begin);
+
+        if (decimal.fractional)
+        {
+          number.type = Token_Float;
+        }
+        else
+        {
+          number.type = Token_Decimal;
+
+          const unsigned long long limit = (unsigned long long)(std::numeric_limits<long long>::max)() + decimal.negative;
+          unsigned long long magnitude = decimal.mantissa;
+          if (decimal.truncated || decimal.exponent != 0 || magnitude > limit)
+          {
+            number.overflow = true;
+            magnitude = limit;
+          }
+
+          number.integer = decimal.negative ? (long long)(0ull - magnitude) : (long long)magnitude;
+        }
+      }
+
+      number.end = charStream - 1;
+      *_outNumber = number;
+      return true;
+    }
+
+    //=========================
+    // Batch tokenization
+    //=========================
+
+    // Appends up to _count tokens to the batch without creating any token strings
+    // Returns the number of tokens appended, fewer than _count once the stream is completed
+    // > Appends nothing and returns 0 if the source is larger than LexerTokenBatch::maxSourceSize
+    // _batch : Output, existing tokens are kept
+    // _count : The most tokens to read
+    // _expectHex, _includeWhitespace (Optional) : See NextToken
+    size_t TokenizeBatch(YTools::LexerTokenBatch& _batch,
+                         size_t _count,
+                         bool _expectHex = false,
+                         bool _includeWhitespace = false)
+    {
+      if (CompletedStream() || !FitsTokenBatch())
+        return 0;
+
+      YTOOLS_LEXER_STAT(YTools::LexerScopedTimer timer(stats.batchNanoseconds));
+      YTools::BasicLexer<std::string_view, Policy> view(charStream, (size_t)(streamEnd + 1 - charStream), usesHex);
+
+      size_t appended = 0;
+      while (appended < _count)
+      {
+        YTools::LexerTokenView token = view.NextToken(_expectHex, _includeWhitespace);
+        if (token.type == Token_End)
+          break;
+
+        _batch.Push(token.type, (uint32_t)(token.start - streamStart), (uint32_t)token.string.size());
+        appended++;
+      }
+
+      charStream = view.charStream;
+      YTOOLS_LEXER_STAT(stats.Add(view.stats));
+      return appended;
+    }
+
+    // Appends every remaining token to the batch without creating any token strings
+    // Returns the number of tokens appended
+    size_t TokenizeAll(YTools::LexerTokenBatch& _batch, bool _expectHex = false, bool _includeWhitespace = false)
+    {
+      return TokenizeBatch(_batch, (size_t)-1, _expectHex, _includeWhitespace);
+    }
+
+    // Splits the rest of the stream into chunks and lexes them on worker threads
+    // > Appends the same tokens as TokenizeAll. Each chunk is lexed speculatively from its split point,
+    //   then joined where its token boundaries line up with the previous chunk's, re-lexing serially if they never do
+    // Returns the number of tokens appended, 0 if the source is larger than LexerTokenBatch::maxSourceSize
+    // _batch : Output, existing tokens are kept
+    // _threadCount (Optional) : The number of chunks to lex at once, 0 uses every hardware thread
+    // _expectHex, _includeWhitespace (Optional) : See NextToken
+    // _isSplitPoint (Optional) : Returns true if the position is a good place to start a chunk
+    // > Defaults to the start of a line. Only affects how often chunks need re-lexing, never the result
+    size_t TokenizeParallel(YTools::LexerTokenBatch& _batch,
+                            unsigned int _threadCount = 0,
+                            bool _expectHex = false,
+                            bool _includeWhitespace = false,
+                            const std::function<bool(const char* _position)>& _isSplitPoint = nullptr)
+    {
+      if (CompletedStream() || !FitsTokenBatch())
+        return 0;
+
+      if (_threadCount == 0)
+        _threadCount = std::thread::hardware_concurrency();
+
+      const char* begin = charStream;
+      const char* end = streamEnd + 1;
+      const size_t length = (size_t)(end - begin);
+
+      if (_threadCount > length / parallelMinimumChunk)
+        _threadCount = (unsigned int)(length / parallelMinimumChunk);
+
+      if (_threadCount <= 1)
+        return TokenizeAll(_batch, _expectHex, _includeWhitespace);
+
+      YTOOLS_LEXER_STAT(YTools::LexerScopedTimer timer(stats.batchNanoseconds));
+
+      // Split points =====
+      std::vector<const char*> splits(_threadCount + 1);
+      splits[0] = begin;
+      splits[_threadCount] = end;
+
+      for (unsigned int i = 1; i < _threadCount; i++)
+      {
+        const char* target = begin + length / _threadCount * i;
+        const char* limit = begin + length / _threadCount * (i + 1);
+        const char* split = target;
+
+        if (_isSplitPoint == nullptr)
+        {
+          const char* newline = LexerScan::FindChar(target, limit, '\n');
+          split = (newline < limit) ? newline + 1 : target;
+        }
+        else
+        {
+          while (split < limit && !_isSplitPoint(split))
+            split++;
+
+          if (split == limit)
+            split = target;
+        }
+
+        splits[i] = (split > splits[i - 1]) ? split : splits[i - 1];
+      }
+
+      // Speculative lexing =====
+      // Each chunk reads until its head passes the next split, so its last token may cross into the next chunk
+      std::vector<YTools::LexerTokenBatch> chunks(_threadCount);
+      std::vector<const char*> chunkHeads(_threadCount);
+      YTOOLS_LEXER_STAT(std::vector<YTools::LexerStats> chunkStats(_threadCount));
+
+      auto lexChunk = [&](unsigned int _index) {
+        YTools::BasicLexer<std::string_view, Policy> view(splits[_index], (size_t)(end - splits[_index]), usesHex);
+
+        while (view.charStream < splits[_index + 1])
+        {
+          YTools::LexerTokenView token = view.NextToken(_expectHex, _includeWhitespace);
+          if (token.type == Token_End)
+            break;
+
+          chunks[_index].Push(token.type, (uint32_t)(token.start - streamStart), (uint32_t)token.string.size());
+        }
+
+        chunkHeads[_index] = view.charStream;
+        YTOOLS_LEXER_STAT(chunkStats[_index] = view.stats);
+      };
+
+      std::vector<std::thread> workers;
+      workers.reserve(_threadCount - 1);
+      for (unsigned int i = 1; i < _threadCount; i++)
+      {
+        workers.emplace_back(lexChunk, i);
+      }
+
+      lexChunk(0);
+
+      for (std::thread& worker : workers)
+      {
+        worker.join();
+      }
+
+#if defined(YTOOLS_LEXER_STATS)
+      for (const YTools::LexerStats& chunk : chunkStats)
+      {
+        stats.Add(chunk);
+      }
+#endif // YTOOLS_LEXER_STATS
+
+      // Join chunks =====
+      // Chunks are read with NextToken alone, so each token depends only on the bytes from where it was read
+      // > Once the serial head lands on a head the chunk also reached, the rest of the chunk is what a serial run reads
+      const size_t initialSize = _batch.Size();
+      const char* head = chunkHeads[0];
+      AppendBatch(_batch, chunks[0], 0);
+
+      for (unsigned int i = 1; i < _threadCount; i++)
+      {
+        const YTools::LexerTokenBatch& chunk = chunks[i];
+
+        // Chunk heads : the split point, then the end of each token
+        size_t resume = 0;
+        const char* chunkHead = splits[i];
+
+        YTools::BasicLexer<std::string_view, Policy> view(head, (size_t)(end - head), usesHex);
+
+        while (true)
+        {
+          while (resume < chunk.Size() && chunkHead < view.charStream)
+          {
+            chunkHead = streamStart + chunk.offsets[resume] + chunk.lengths[resume];
+            resume++;
+          }
+
+          if (chunkHead == view.charStream)
+          {
+            AppendBatch(_batch, chunk, resume);
+            head = chunkHeads[i];
+            break;
+          }
+
+          // Chunk never lined up before its end, continue to the next chunk's split point
+          if (resume == chunk.Size() && view.charStream >= splits[i + 1])
+          {
+            head = view.charStream;
+            break;
+          }
+
+          YTools::LexerTokenView token = view.NextToken(_expectHex, _includeWhitespace);
+          if (token.type == Token_End)
+          {
+            head = view.charStream;
+            break;
+          }
+
+          _batch.Push(token.type, (uint32_t)(token.start - streamStart), (uint32_t)token.string.size());
+        }
+
+        YTOOLS_LEXER_STAT(stats.Add(view.stats));
+      }
+
+      charStream = head;
+      return _batch.Size() - initialSize;
+    }
+
+    // Updates the tokens of a string after an edit, re-lexing only the tokens the edit can affect
+    // > The lexer must be over the edited string, and the batch read with TokenizeAll from the start of the original
+    // > Re-lexing stops once a token ends where a token of the original string ended past the edit,
+    //   every following token is unchanged and only has its offset shifted
+    // > Does not move the read head
+    // Returns false if the edit does not fit in the lexer's string, or the string is larger than
+    //   LexerTokenBatch::maxSourceSize, leaving the batch unchanged
+    // _batch : The tokens of the original string, updated to the tokens of the edited string
+    // _edit : The edit that was applied to the string
+    // _outRange (Optional) : Output for the tokens that were re-lexed
+    // _expectHex, _includeWhitespace (Optional) : Must match the values the batch was read with
+    bool RelexEdit(YTools::LexerTokenBatch& _batch,
+                   const YTools::LexerEdit& _edit,
+                   YTools::LexerRelexRange* _outRange = nullptr,
+                   bool _expectHex = false,
+                   bool _includeWhitespace = false)
+    {
+      const size_t size = (size_t)(streamEnd + 1 - streamStart);
+      if ((size_t)_edit.offset + _edit.inserted > size || !FitsTokenBatch())
+        return false;
+
+      YTOOLS_LEXER_STAT(YTools::LexerScopedTimer timer(stats.batchNanoseconds));
+
+      const size_t editEnd = (size_t)_edit.offset + _edit.inserted;
+      const long long shift = (long long)_edit.inserted - (long long)_edit.removed;
+
+      auto tokenEnd = [&](size_t _index) {
+        return (size_t)_batch.offsets[_index] + _batch.lengths[_index];
+      };
+
+      // Restart point =====
+      // The first token that may have inspected a byte at or past the edit, every token before it is unchanged
+      size_t low = 0;
+      size_t high = _batch.Size();
+      while (low < high)
+      {
+        size_t middle = low + (high - low) / 2;
+        if (tokenEnd(middle) + tokenLookahead < _edit.offset)
+          low = middle + 1;
+        else
+          high = middle;
+      }
+
+      const size_t first = low;
+      const char* head = streamStart + (first > 0 ? tokenEnd(first - 1) : 0);
+
+      // Re-lex =====
+      // The view is fresh and only calls NextToken, so no lookahead is held and each token follows from the bytes at its head
+      // > Past the edit those bytes match the original's, so once a head lines up with one of the original,
+      //   the rest of the original's tokens are read again unchanged
+      YTools::LexerTokenBatch relexed;
+      YTools::BasicLexer<std::string_view, Policy> view(head, (size_t)(streamStart + size - head), usesHex);
+
+      size_t resume = first; // The first original token not yet passed
+      bool synced = false;
+
+      while (!synced)
+      {
+        YTools::LexerTokenView token = view.NextToken(_expectHex, _includeWhitespace);
+        if (token.type == Token_End)
+          break;
+
+        relexed.Push(token.type, (uint32_t)(token.start - streamStart), (uint32_t)token.string.size());
+
+        const size_t newHead = (size_t)(view.charStream - streamStart);
+        if (newHead < editEnd)
+          continue;
+
+        const size_t originalHead = (size_t)((long long)newHead - shift);
+        while (resume < _batch.Size() && tokenEnd(resume) < originalHead)
+          resume++;
+
+        if (resume < _batch.Size() && tokenEnd(resume) == originalHead)
+        {
+          resume++;
+          synced = true;
+        }
+      }
+
+      if (!synced)
+        resume = _batch.Size();
+
+      YTOOLS_LEXER_STAT(stats.Add(view.stats));
+
+      // Splice =====
+      for (size_t i = resume; i < _batch.Size(); i++)
+      {
+        _batch.offsets[i] = (uint32_t)((long long)_batch.offsets[i] + shift);
+      }
+
+      _batch.types.erase(_batch.types.begin() + first, _batch.types.begin() + resume);
+      _batch.offsets.erase(_batch.offsets.begin() + first, _batch.offsets.begin() + resume);
+      _batch.lengths.erase(_batch.lengths.begin() + first, _batch.lengths.begin() + resume);
+
+      _batch.types.insert(_batch.types.begin() + first, relexed.types.begin(), relexed.types.end());
+      _batch.offsets.insert(_batch.offsets.begin() + first, relexed.offsets.begin(), relexed.offsets.end());
+      _batch.lengths.insert(_batch.lengths.begin() + first, relexed.lengths.begin(), relexed.lengths.end());
+
+      if (_outRange != nullptr)
+        *_outRange = { first, relexed.Size(), resume - first };
+
+      return true;
+    }
+
+    //=========================
+    // Numbers
+    //=========================
+
+    // Conversions read the token's characters in place and stop at the first character that is not a digit
+    // _outOverflow (Optional) : Set to true if the value does not fit the returned type, which is then saturated
+
+    // Decimal =====
+
+    // Returns an unsigned int
+    unsigned int GetUIntFromToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetUnsignedFromToken<unsigned int>(_token, 10, _outOverflow); // Ignores negative sign if present
+    }
+
+    // Returns a signed int
+    int GetIntFromToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetSignedFromToken<int>(_token, 10, _outOverflow);
+    }
+
+    // Returns an unsigned long
+    unsigned long GetULongFromToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetUnsignedFromToken<unsigned long>(_token, 10, _outOverflow); // Ignores negative sign if present
+    }
+
+    // Returns a signed long
+    long GetLongFromToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetSignedFromToken<long>(_token, 10, _outOverflow);
+    }
+
+    // Hex =====
+    // > Ignores negative signs and "0x" tags
+    // > Signed results are the bit pattern of the value, "0xffffffff" is -1 as an int
+
+    // Returns an unsigned int
+    unsigned int GetUIntFromHexToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetUnsignedFromToken<unsigned int>(_token, 16, _outOverflow);
+    }
+
+    // Returns a signed int
+    int GetIntFromHexToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return (int)GetUnsignedFromToken<unsigned int>(_token, 16, _outOverflow);
+    }
+
+    // Returns an unsigned long
+    unsigned long GetULongFromHexToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetUnsignedFromToken<unsigned long>(_token, 16, _outOverflow);
+    }
+
+    // Returns a signed long
+    long GetLongFromHexToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return (long)GetUnsignedFromToken<unsigned long>(_token, 16, _outOverflow);
     }
 
     // Binary =====
 
     // Returns an unsigned int
-    unsigned int GetUIntFromBinaryToken(const YTools::LexerToken* _token)
+    unsigned int GetUIntFromBinaryToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetUnsignedFromToken<unsigned int>(_token, 2, _outOverflow); // Ignores negative sign if present
+    }
+
+    // Returns a signed int
+    int GetIntFromBinaryToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetSignedFromToken<int>(_token, 2, _outOverflow);
+    }
+
+    // Returns an unsigned long
+    unsigned long GetULongFromBinaryToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetUnsignedFromToken<unsigned long>(_token, 2, _outOverflow); // Ignores negative sign if present
+    }
+
+    // Returns a signed long
+    long GetLongFromBinaryToken(const Token* _token, bool* _outOverflow = nullptr)
+    {
+      return GetSignedFromToken<long>(_token, 2, _outOverflow);
+    }
+
+    // Float =====
+
+    // Returns a float, correctly rounded
+    float GetFloatFromToken(const Token* _token)
+    {
+      const char* begin = _token->string.data();
+      return LexerParse::ParseFloatingPoint<float>(begin, begin + _token->string.size());
+    }
+
+    // Returns a double, correctly rounded
+    double GetDoubleFromToken(const Token* _token)
+    {
+      const char* begin = _token->string.data();
+      return LexerParse::ParseFloatingPoint<double>(begin, begin + _token->string.size());
+    }
+
+    // String literals =====
+
+    // Returns the contents of a Token_StringLiteral without its quotes, with escape sequences replaced
+    // > '\n', '\t', '\r', and '\0' become their control characters, any other escaped character is kept as is
+    std::string GetStringFromLiteralToken(const Token* _token)
+    {
+      const char* position = _token->string.data();
+      const char* end = position + _token->string.size();
+
+      std::string value;
+      if (position == end)
+        return value;
+
+      const char quote = *position++;
+      value.reserve((size_t)(end - position));
+
+      while (position < end)
+      {
+        const char* next;
+        if constexpr (Policy::stringEscape != '\0')
+          next = LexerScan::FindEither(position, end, quote, Policy::stringEscape);
+        else
+          next = LexerScan::FindChar(position, end, quote);
+
+        value.append(position, (size_t)(next - position));
+
+        // Closing quote, or unterminated
+        if (next + 1 >= end || *next == quote)
+          break;
+
+        switch (next[1])
+        {
+        case 'n': value.push_back('\n'); break;
+        case 't': value.push_back('\t'); break;
+        case 'r': value.push_back('\r'); break;
+        case '0': value.push_back('\0'); break;
+        default: value.push_back(next[1]); break;
+        }
+
+        position = next + 2;
+      }
+
+      return value;
+    }
+
+    //=========================
+    // Backtracking
+    //=========================
+
+    // Saves the current read position
+    // > Only the position is saved, tokens moved past after the checkpoint are lexed again once restored
+    // > Peeked tokens stay cached if none of them were consumed, the lookahead is keyed by the head it was read from
+    YTools::LexerCheckpoint Checkpoint() const
+    {
+      return { charStream };
+    }
+
+    // Moves the read head back (or forward) to a saved position
+    // Returns false if the checkpoint does not belong to this lexer's string
+    bool Restore(const YTools::LexerCheckpoint& _checkpoint)
+    {
+      if (_checkpoint.head < streamStart || _checkpoint.head > streamEnd + 1)
+        return false;
+
+      charStream = _checkpoint.head;
+      YTOOLS_LEXER_STAT(stats.restores++);
+      return true;
+    }
+
+    // Restores the lexer to its position at construction when leaving scope, unless committed
+    // > { Lexer::Speculation attempt(lexer); if (!ParseRule(lexer)) return false; attempt.Commit(); }
+    class Speculation
+    {
+    public:
+      Speculation(BasicLexer& _lexer) : lexer(_lexer), checkpoint(_lexer.Checkpoint())
+      {}
+
+      ~Speculation()
+      {
+        if (!committed)
+          lexer.Restore(checkpoint);
+      }
+
+      Speculation(const Speculation&) = delete;
+      Speculation& operator=(const Speculation&) = delete;
+
+      // Keeps the lexer's current position when leaving scope
+      void Commit()
+      {
+        committed = true;
+      }
+
+    private:
+      BasicLexer& lexer;
+      const YTools::LexerCheckpoint checkpoint;
+      bool committed = false;
+    };
+
+    //=========================
+    // Additional tools
+    //=========================
+
+    // Compares the token string with the array of strings
+    // Returns [0, _count) as the index of the matching string, _count if no match was found
+    unsigned int GetTokenSetIndex(const Token& _token, const char* const* _stringArray, unsigned int _count)
+    {
+      unsigned int index;
+      for (index = 0; index < _count; index++)
+      {
+        if (_token.string.compare(_stringArray[index]) == 0)
+          return index;
+      }
+
+      return index;
+    }
+
+    // Looks the token string up in the compile-time keyword set
+    // Returns [0, Count) as the index of the matching keyword, Count if no match was found
+    template <unsigned int Count>
+    unsigned int GetTokenSetIndex(const Token& _token, const YTools::LexerKeywordSet<Count>& _keywords)
+    {
+      return _keywords.IndexOf(std::string_view(_token.string));
+    }
+
+    // Peek at the next token's string in the stream
+    // _count (Optional) : The number of characters to look at (including whitespace)
+    // > 0 looks at the next token, skipping whitespace
+    TokenString Peek(unsigned long long _count = 0)
+    {
+      if (_count == 0)
+        return PeekToken().string;
+
+      // Skip whitespace =====
+      // Done to preserve the token start position standard
+      const char* stringBeginning = ScanWhitespace(charStream);
+
+      // Read =====
+      size_t remaining = stringBeginning > streamEnd ? 0 : (size_t)(streamEnd + 1 - stringBeginning);
+      size_t stringLength = _count < remaining ? (size_t)_count : remaining;
+
+      return MakeTokenString(stringBeginning, stringLength);
+    }
+
+    // Returns the token the next NextToken call will return, without moving forward in the read string
+    // > Cached, repeated peeks and the following NextToken or ExpectType do not lex the token again
+    // > The reference is valid until the lexer moves forward
+    const Token& PeekToken()
+    {
+      // A head match means the ring holds at least one token
+      if (lookaheadHead == charStream)
+        return *lookahead[lookaheadFirst];
+
+      return LookAhead(0);
+    }
+
+    // Returns the token _k tokens after the next one, without moving forward in the read string
+    // > Tokens are read as NextToken() reads them and held in a ring, each is lexed once however often it is looked at
+    // > The reference is valid until the lexer moves past the token, or to a position outside the held tokens
+    // _k : Less than lookaheadCapacity, larger values return the last token the ring can hold
+    const Token& LookAhead(size_t _k)
+    {
+      if (lookaheadHead != charStream || _k >= lookaheadCount)
+        FillLookahead(_k < lookaheadCapacity ? _k : lookaheadCapacity - 1);
+
+      return *lookahead[(lookaheadFirst + (_k < lookaheadCapacity ? _k : lookaheadCapacity - 1)) % lookaheadCapacity];
+    }
+
+    // Range =====
+    // for (const Lexer::Token& token : lexer), or std::ranges pipelines over the lexer
+    // > Yields the tokens NextToken() would, up to but not including Token_End
+    // > Each token is lexed once into the lookahead ring, advancing consumes it
+
+    // Compares equal to an iterator once its lexer reaches the end of the stream
+    struct TokenSentinel
+    {};
+
+    // Single-pass iterator over the remaining tokens, incrementing moves the lexer forward
+    class TokenIterator
+    {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = Token;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const Token*;
+      using reference = const Token&;
+
+      TokenIterator() = default;
+
+      explicit TokenIterator(BasicLexer* _lexer) : lexer(_lexer)
+      {}
+
+      const Token& operator*() const
+      {
+        return lexer->PeekToken();
+      }
+
+      const Token* operator->() const
+      {
+        return &lexer->PeekToken();
+      }
+
+      TokenIterator& operator++()
+      {
+        lexer->NextToken();
+        return *this;
+      }
+
+      void operator++(int)
+      {
+        ++*this;
+      }
+
+      friend bool operator==(const TokenIterator& _iterator, TokenSentinel)
+      {
+        return _iterator.lexer == nullptr || _iterator.lexer->PeekToken().type == Token_End;
+      }
+
+      friend bool operator==(TokenSentinel _sentinel, const TokenIterator& _iterator)
+      {
+        return _iterator == _sentinel;
+      }
+
+      friend bool operator!=(const TokenIterator& _iterator, TokenSentinel _sentinel)
+      {
+        return !(_iterator == _sentinel);
+      }
+
+      friend bool operator!=(TokenSentinel _sentinel, const TokenIterator& _iterator)
+      {
+        return !(_iterator == _sentinel);
+      }
+
+    private:
+      BasicLexer* lexer = nullptr;
+    };
+
+    TokenIterator begin()
+    {
+      return TokenIterator(this);
+    }
+
+    TokenSentinel end()
+    {
+      return {};
+    }
+
+    // Returns the percentage (0-1) within the string at which the read head is positioned
+    float GetProgress()
+    {
+      long long length = streamEnd - streamStart;
+      long long head = charStream - streamStart;
+
+      return (float)((double)head / (double)length);
+    }
+
+    // Returns true if the read head has reached the end of the read string
+    bool CompletedStream()
+    {
+      return charStream > streamEnd;
+    }
+
+    // Returns the line and column of a position in the read string
+    // > The first call indexes every line of the string, later calls are a binary search
+    YTools::LexerLocation GetLocation(const char* _position)
+    {
+      if (!lineIndex.IsBuilt())
+        lineIndex.Build(streamStart, (size_t)(streamEnd + 1 - streamStart));
+
+      return lineIndex.Locate((size_t)(_position - streamStart));
+    }
+
+    // Returns the line and column of the token's first character
+    YTools::LexerLocation GetLocation(const Token& _token)
+    {
+      return GetLocation(_token.start);
+    }
+
+    // Returns the line and column of the read head
+    YTools::LexerLocation GetLocation()
+    {
+      return GetLocation(charStream);
+    }
+
+    //=========================
+    // Token generation
+    //=========================
+  private:
+
+    // Chunks smaller than this are not worth a thread in TokenizeParallel
+    static constexpr size_t parallelMinimumChunk = 0x10000;
+
+    // ReadToFirst or ReadThroughFirst for at most two keys, without building a LexerKeySet
+    // _through : Includes the found key in the token
+    unsigned int ReadToFewKeys(std::string_view _keys, bool _through, Token* _outToken)
     {
-      int offset = _token->string[0] == '-'; // Ignores negative sign if present
-      return (unsigned int)strtoul(_token->string.c_str() + offset, nullptr, 2);
+      const char* stringBeginning = charStream;
+      const char* end = streamEnd + 1;
+
+      if (_keys.empty())
+        charStream = (charStream < end) ? end : charStream;
+      else if (_keys.size() == 1)
+        charStream = LexerScan::FindChar(charStream, end, _keys[0]);
+      else
+        charStream = LexerScan::FindEither(charStream, end, _keys[0], _keys[1]);
+
+      unsigned int keyFound = -1;
+      if (!CompletedStream())
+      {
+        keyFound = (unsigned int)_keys.find(*charStream);
+        charStream += _through;
+      }
+
+      unsigned int stringLength = (unsigned int)(charStream - stringBeginning);
+
+      if (_outToken != nullptr)
+      {
+        OutputToken(_outToken,
+                    { Token_String,
+                      MakeTokenString(stringBeginning, stringLength),
+                      stringBeginning,
+                      stringBeginning + stringLength - 1 });
+      }
+
+      return keyFound;
     }
 
-    // Returns a signed int
-    int GetIntFromBinaryToken(const YTools::LexerToken* _token)
+    // Whether every offset of the source fits in a LexerTokenBatch
+    bool FitsTokenBatch() const
     {
-      return (int)strtol(_token->string.c_str(), nullptr, 2);
+      return (size_t)(streamEnd + 1 - streamStart) <= YTools::LexerTokenBatch::maxSourceSize;
     }
 
-    // Returns an unsigned long
-    unsigned long GetULongFromBinaryToken(const YTools::LexerToken* _token)
+    // Creates token strings, from the memory resource when TokenString uses a polymorphic allocator
+    TokenString MakeTokenString(const char* _begin, size_t _length) const
     {
-      int offset = _token->string[0] == '-'; // Ignores negative sign if present
-      return strtoul(_token->string.c_str() + offset, nullptr, 2);
+      if constexpr (usesMemoryResource)
+        return TokenString(_begin, _length, memoryResource);
+      else
+        return TokenString(_begin, _length);
     }
 
-    // Returns a signed long
-    long GetLongFromBinaryToken(const YTools::LexerToken* _token)
+    // Moves a token into an _outToken parameter
+    // > Assigning a std::pmr::string keeps the target's allocator, so the target is rebuilt to take the
+    //   token's string from the lexer's memory resource
+    void OutputToken(Token* _outToken, Token&& _token) const
     {
-      return strtol(_token->string.c_str(), nullptr, 2);
+      if constexpr (usesMemoryResource)
+      {
+        std::destroy_at(_outToken);
+        ::new ((void*)_outToken) Token(std::move(_token));
+      }
+      else
+        *_outToken = std::move(_token);
     }
 
-    // Float =====
+    // Policy =====
+
+    static constexpr bool usesMemoryResource =
+      std::uses_allocator_v<TokenString, std::pmr::polymorphic_allocator<char>>;
 
-    // Returns a float
-    float GetFloatFromToken(const YTools::LexerToken* _token)
+    static constexpr bool hasComments = !Policy::lineComment.empty() || !Policy::blockCommentOpen.empty();
+    static constexpr bool hasStringLiterals = !Policy::stringQuotes.empty();
+    static constexpr YTools::LexerKeySet quoteKeys { Policy::stringQuotes };
+
+    static constexpr bool simdWhitespace = Policy::characters.SameFlags(lexerCharacters, Char_Whitespace);
+    static constexpr bool simdIdentifier = Policy::characters.SameFlags(lexerCharacters, Char_Identifier);
+
+    bool UsesHex() const
     {
-      return strtof(_token->string.c_str(), nullptr);
+      if constexpr (Policy::hexNumbers == Option_Runtime)
+        return usesHex;
+      else
+        return Policy::hexNumbers == Option_Always;
     }
 
-    // Returns a double
-    double GetDoubleFromToken(const YTools::LexerToken* _token)
+    bool ExpectsHex(bool _expectHex) const
     {
-      return strtod(_token->string.c_str(), nullptr);
+      if constexpr (Policy::hexNumbers == Option_Runtime)
+        return _expectHex;
+      else
+        return Policy::hexNumbers == Option_Always;
     }
 
-    //=========================
-    // Additional tools
-    //=========================
+    bool IncludesWhitespace(bool _includeWhitespace) const
+    {
+      if constexpr (Policy::whitespaceTokens == Option_Runtime)
+        return _includeWhitespace;
+      else
+        return Policy::whitespaceTokens == Option_Always;
+    }
 
-    // Compares the token string with the array of strings
-    // Returns [0, _count) as the index of the matching string, _count if no match was found
-    unsigned int GetTokenSetIndex(const YTools::LexerToken& _token, const char* const* _stringArray, unsigned int _count)
+    // Returns the first byte at or after _position that is not whitespace
+    const char* ScanWhitespace(const char* _position) const
     {
-      unsigned int index;
-      for (index = 0; index < _count; index++)
-      {
-        if (_token.string.compare(_stringArray[index]) == 0)
-          return index;
-      }
+      if constexpr (simdWhitespace)
+        return LexerScan::SkipWhitespace(_position, streamEnd + 1);
+      else
+        return LexerScan::SkipFlags(_position, streamEnd + 1, Policy::characters, Char_Whitespace);
+    }
 
-      return index;
+    // Returns the first byte at or after _position that can not continue a string token
+    const char* ScanIdentifier(const char* _position) const
+    {
+      if constexpr (simdIdentifier)
+        return LexerScan::SkipIdentifier(_position, streamEnd + 1);
+      else
+        return LexerScan::SkipFlags(_position, streamEnd + 1, Policy::characters, Char_Identifier);
     }
 
-    // Peek at the next token's string in the stream
-    // _count (Optional) : The number of characters to look at (including whitespace)
-    // > 0 looks at the next token, skipping whitespace
-    std::string Peek(unsigned long long _count = 0)
+    // Appends the tokens of _source starting at _first
+    void AppendBatch(YTools::LexerTokenBatch& _batch, const YTools::LexerTokenBatch& _source, size_t _first)
     {
-      if (_count == 0)
-      {
-        const char* head = charStream;
-        YTools::LexerToken token = NextToken();
+      _batch.types.insert(_batch.types.end(), _source.types.begin() + _first, _source.types.end());
+      _batch.offsets.insert(_batch.offsets.end(), _source.offsets.begin() + _first, _source.offsets.end());
+      _batch.lengths.insert(_batch.lengths.end(), _source.lengths.begin() + _first, _source.lengths.end());
+    }
 
-        charStream = head;
-        return token.string;
-      }
+    // Reads the token as an unsigned value, ignoring a negative sign and (in base 16) a "0x" tag
+    template <typename Type>
+    Type GetUnsignedFromToken(const Token* _token, unsigned int _base, bool* _outOverflow)
+    {
+      const char* begin = _token->string.data();
+      const char* end = begin + _token->string.size();
 
-      // Skip whitespace =====
-      // Done to preserve the token start position standard
-      while (!CompletedStream() && IsWhiteSpace(*charStream))
-      {
-        charStream++;
-      };
+      // Ignores negative sign if present
+      begin += (begin < end && *begin == '-');
+      // Ignores "0x" if present
+      if (_base == 16 && end - begin > 2 && begin[0] == '0' && begin[1] == 'x')
+        begin += 2;
 
-      // Read =====
-      const char* stringBeginning = charStream;
-      unsigned int stringLength = 0;
+      unsigned long long value;
+      bool overflow = false;
+      LexerParse::ParseUnsigned(begin, end, _base, &value, &overflow);
 
-      while (stringLength < _count && !CompletedStream())
+      if (value > (std::numeric_limits<Type>::max)())
       {
-        charStream++;
-        stringLength++;
+        overflow = true;
+        value = (std::numeric_limits<Type>::max)();
       }
 
-      return std::string(stringBeginning, stringLength);
+      if (overflow && _outOverflow != nullptr)
+        *_outOverflow = true;
+
+      return (Type)value;
     }
 
-    // Returns the percentage (0-1) within the string at which the read head is positioned
-    float GetProgress()
+    template <typename Type>
+    Type GetSignedFromToken(const Token* _token, unsigned int _base, bool* _outOverflow)
     {
-      long long length = streamEnd - streamStart;
-      long long head = charStream - streamStart;
+      const char* begin = _token->string.data();
 
-      return (float)((double)head / (double)length);
-    }
+      long long value;
+      bool overflow = false;
+      LexerParse::ParseSigned(begin, begin + _token->string.size(), _base, &value, &overflow);
 
-    // Returns true if the read head has reached the end of the read string
-    bool CompletedStream()
-    {
-      return charStream > streamEnd;
-    }
+      if (value > (std::numeric_limits<Type>::max)())
+      {
+        overflow = true;
+        value = (std::numeric_limits<Type>::max)();
+      }
+      else if (value < (std::numeric_limits<Type>::min)())
+      {
+        overflow = true;
+        value = (std::numeric_limits<Type>::min)();
+      }
 
-    //=========================
-    // Token generation
-    //=========================
-  private:
+      if (overflow && _outOverflow != nullptr)
+        *_outOverflow = true;
 
-    YTools::LexerToken GetSingleCharToken(YTools::TokenTypes _type)
+      return (Type)value;
+    }
+
+    Token GetSingleCharToken(YTools::TokenTypes _type)
     {
-      return { _type, std::string(charStream, 1), charStream++ };
+      const char* character = charStream++;
+      return { _type, MakeTokenString(character, 1), character, character };
     }
 
-    YTools::LexerToken GetStringToken()
+    Token GetStringToken()
     {
       const char* stringBegining = charStream;
       unsigned int stringLength = 0;
 
-      while (IsString(*charStream) && !CompletedStream())
-      {
-        charStream++;
-        stringLength++;
-      }
+      charStream = ScanIdentifier(charStream);
+      stringLength = (unsigned int)(charStream - stringBegining);
 
       return { Token_String,
-               std::string(stringBegining, stringLength),
+               MakeTokenString(stringBegining, stringLength),
                stringBegining,
                stringBegining + stringLength - 1 };
     }
 
-    YTools::LexerToken GetNumberToken(bool _isHex = false)
+    Token GetNumberToken(bool _isHex = false)
     {
       const char* stringBegining = charStream;
       unsigned int stringLength = 0;
 
       int offset = *stringBegining == '-';
 
-      // Handle hyphen-only
-      if (offset && !IsNumber(*charStream))
+      if (offset)
       {
-        charStream--;
-        return GetSingleCharToken(Token_Hyphen);
+        // Handle hyphen-only
+        if (charStream + 1 > streamEnd || !IsNumber(*(charStream + 1)))
+        {
+          return GetSingleCharToken(Token_Hyphen);
+        }
+
+        // Include the sign
+        charStream++;
+        stringLength++;
       }
 
       // Hex test =====
@@ -638,7 +3025,8 @@ namespace YTools {
       {
         type = YTools::Token_Hex;
       }
-      else if (*(stringBegining + offset) == '0' && *(stringBegining + offset + 1) == 'x')
+      else if (stringBegining + offset + 1 <= streamEnd &&
+               *(stringBegining + offset) == '0' && *(stringBegining + offset + 1) == 'x')
       {
         type = YTools::Token_Hex;
 
@@ -649,7 +3037,7 @@ namespace YTools {
 
       // Read number =====
 
-      while (IsNumber(*charStream, type) && !CompletedStream())
+      while (!CompletedStream() && IsNumber(*charStream, type))
       {
         if (*charStream == '.')
         {
@@ -665,159 +3053,395 @@ namespace YTools {
         stringLength++;
       }
 
-      return { type, std::string(stringBegining, stringLength), stringBegining };
+      if (type != YTools::Token_Hex && SkipExponent())
+      {
+        type = Token_Float;
+        stringLength = (unsigned int)(charStream - stringBegining);
+      }
+
+      return { type,
+               MakeTokenString(stringBegining, stringLength),
+               stringBegining,
+               stringBegining + stringLength - 1 };
     }
 
-    YTools::LexerToken GetWhitespaceToken()
+    // Moves past an exponent ('e' or 'E', optional sign, digits) if one is at the read head
+    // > Only taken when a digit follows, "1e" is still a number and a string
+    bool SkipExponent()
     {
-      const char* stringBeginning = charStream++;
-      unsigned int stringLength = 1;
+      if (charStream + 1 > streamEnd || (*charStream != 'e' && *charStream != 'E'))
+        return false;
+
+      const char* exponent = charStream + 1;
+      if (exponent < streamEnd && (*exponent == '-' || *exponent == '+'))
+        exponent++;
+
+      if (!(Policy::characters[*exponent].flags & Char_Digit))
+        return false;
 
-      while (!CompletedStream() && IsWhiteSpace(*charStream))
+      charStream = exponent;
+      while (!CompletedStream() && (Policy::characters[*charStream].flags & Char_Digit))
       {
         charStream++;
-        stringLength++;
       }
 
-      return { Token_Whitespace,
-               std::string(stringBeginning, stringLength),
+      return true;
+    }
+
+    // Creates a token from the read head to _end, and moves the head to _end
+    Token GetSpanToken(YTools::TokenTypes _type, const char* _end)
+    {
+      const char* stringBeginning = charStream;
+      unsigned int stringLength = (unsigned int)(_end - stringBeginning);
+      charStream = _end;
+
+      return { _type,
+               MakeTokenString(stringBeginning, stringLength),
                stringBeginning,
                stringBeginning + stringLength - 1 };
     }
 
-    YTools::TokenTypes GetCharacterType(char _char, bool _expectHex = false)
+    // Returns true if the string is at _position, and fits before the end of the stream
+    bool StartsWith(const char* _position, std::string_view _string) const
     {
-      if (CompletedStream())
-        return Token_End;
+      return (size_t)(streamEnd + 1 - _position) >= _string.size() &&
+             memcmp(_position, _string.data(), _string.size()) == 0;
+    }
 
-      // Get token =====
-      switch (_char)
+    // Returns the position after the first instance of the key string at or after _position
+    // > The end of the stream if there is none
+    const char* FindThrough(const char* _position, std::string_view _key) const
+    {
+      const char* end = streamEnd + 1;
+
+      while (true)
       {
-      case '-':
-      case '0': case '1': case '2': case '3': case '4':
-      case '5': case '6': case '7': case '8': case '9':
-        return Token_Decimal;
-      case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
-      case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
+        _position = LexerScan::FindChar(_position, end, _key[0]);
+        if (_position == end)
+          return end;
+
+        if (StartsWith(_position, _key))
+          return _position + _key.size();
+
+        _position++;
+      }
+    }
+
+    // Returns the position after the comment starting at _position, nullptr if no comment starts there
+    // > Line comments end before their '\n', unterminated block comments run to the end of the stream
+    const char* SkipComment(const char* _position) const
+    {
+      if constexpr (!Policy::lineComment.empty())
       {
-        if (_expectHex)
-        {
-          return Token_Hex;
-        }
+        if (StartsWith(_position, Policy::lineComment))
+          return LexerScan::FindChar(_position + Policy::lineComment.size(), streamEnd + 1, '\n');
       }
-      case 'G': case 'H': case 'I': case 'J': case 'K': case 'L':
-      case 'M': case 'N': case 'O': case 'P': case 'Q': case 'R':
-      case 'S': case 'T': case 'U': case 'V': case 'W': case 'X':
-      case 'Y': case 'Z':
-      case '_':
-      case 'g': case 'h': case 'i': case 'j': case 'k': case 'l':
-      case 'm': case 'n': case 'o': case 'p': case 'q': case 'r':
-      case 's': case 't': case 'u': case 'v': case 'w': case 'x':
-      case 'y': case 'z':
-        return Token_String;
-      case ',': return Token_Comma;
-      case '[': return Token_LeftBracket;
-      case ']': return Token_RightBracket;
-      case '{': return Token_LeftBrace;
-      case '}': return Token_RightBrace;
-      case '(': return Token_LeftParen;
-      case ')': return Token_RightParen;
-      case '/': return Token_FwdSlash;
-      case '<': return Token_LessThan;
-      case '>': return Token_GreaterThan;
-      case '=': return Token_Equal;
-      case '+': return Token_Plus;
-      case '*': return Token_Star;
-      case '\\': return Token_BackSlash;
-      case '#': return Token_Pound;
-      case '.': return Token_Period;
-      case ';': return Token_SemiColon;
-      case ':': return Token_Colon;
-      case '\'': return Token_Apostrophe;
-      case '"': return Token_Quote;
-      case '|': return Token_Pipe;
-
-      case '\0': return Token_NullTerminator;
-
-      case ' ': case '\n': case '\r': case '\t':
-        return Token_Whitespace;
-
-      default: return Token_Unknown;
+
+      if constexpr (!Policy::blockCommentOpen.empty())
+      {
+        if (StartsWith(_position, Policy::blockCommentOpen))
+          return FindThrough(_position + Policy::blockCommentOpen.size(), Policy::blockCommentClose);
       }
+
+      return nullptr;
     }
 
-    bool IsWhiteSpace(char _char)
+    // Returns the position after the string literal starting with the quote at _position
+    // > Unterminated literals run to the end of the stream
+    const char* SkipStringLiteral(const char* _position) const
     {
-      switch (_char)
+      const char quote = *_position++;
+      const char* end = streamEnd + 1;
+
+      while (true)
       {
-      case ' ':
-      case '\n':
-      case '\r':
-      case '\t':
-        return true;
-      default:
-        return false;
+        if constexpr (Policy::stringEscape != '\0')
+          _position = LexerScan::FindEither(_position, end, quote, Policy::stringEscape);
+        else
+          _position = LexerScan::FindChar(_position, end, quote);
+
+        if (_position == end)
+          return end;
+
+        if (*_position == quote)
+          return _position + 1;
+
+        // Skip the escaped character
+        if (end - _position <= 2)
+          return end;
+
+        _position += 2;
       }
     }
 
+    Token GetWhitespaceToken()
+    {
+      const char* stringBeginning = charStream++;
+
+      charStream = ScanWhitespace(charStream);
+      unsigned int stringLength = (unsigned int)(charStream - stringBeginning);
+
+      return { Token_Whitespace,
+               MakeTokenString(stringBeginning, stringLength),
+               stringBeginning,
+               stringBeginning + stringLength - 1 };
+    }
+
+    YTools::TokenTypes GetCharacterType(char _char, bool _expectHex = false)
+    {
+      if (CompletedStream())
+        return Token_End;
+
+      const YTools::LexerCharacter& character = Policy::characters[_char];
+
+      if (ExpectsHex(_expectHex) && (character.flags & Char_Hex) && !(character.flags & Char_Digit))
+        return Token_Hex;
+
+      return character.type;
+    }
+
+    bool IsWhiteSpace(char _char)
+    {
+      return Policy::characters[_char].flags & Char_Whitespace;
+    }
+
     bool IsNumber(char _char, YTools::TokenTypes _type = YTools::Token_Decimal)
     {
-      if (_type == YTools::Token_Hex)
-      {
-        switch (_char)
-        {
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-        case 'a': case 'A':
-        case 'b': case 'B':
-        case 'c': case 'C':
-        case 'd': case 'D':
-        case 'e': case 'E':
-        case 'f': case 'F':
-          return true;
-        default:
-          return false;
-        }
-      }
-      else
+      const unsigned char mask = (_type == YTools::Token_Hex) ? Char_Hex : Char_Decimal;
+      return Policy::characters[_char].flags & mask;
+    }
+
+    bool IsString(char _char)
+    {
+      return Policy::characters[_char].flags & Char_Identifier;
+    }
+
+  }; // BasicLexer
+
+  using Lexer = BasicLexer<std::string>;
+  using LexerView = BasicLexer<std::string_view>; // Returns LexerTokenView tokens
+  using LexerPmr = BasicLexer<std::pmr::string>; // Returns LexerTokenPmr tokens, see SetMemoryResource
+
+#if defined(__cpp_lib_ranges)
+  static_assert(std::ranges::input_range<Lexer>, "Lexer must be usable in std::ranges pipelines");
+  static_assert(std::sentinel_for<Lexer::TokenSentinel, Lexer::TokenIterator>);
+#endif // __cpp_lib_ranges
+
+  //=========================
+  // Streaming
+  //=========================
+
+  // Lexes input pulled from a reader in chunks, for inputs too large to hold in memory
+  // > Memory use is bounded by the chunk size plus the longest single token or read
+  // > Tokens own their strings, but their start/end pointers are only valid until the next read
+  class LexerStream
+  {
+  public:
+    // Fills up to _size bytes of _buffer
+    // Returns the number of bytes written, 0 once the input is exhausted
+    using Reader = std::function<size_t(char* _buffer, size_t _size)>;
+
+  private:
+    Reader reader;
+    const size_t chunkSize;
+    std::vector<char> buffer;
+    size_t head = 0; // Read position within the buffer
+    size_t filled = 0; // Bytes of input held in the buffer
+    unsigned long long consumed = 0; // Bytes of input read past, used in GetProgress
+    const unsigned long long totalSize; // 0 if unknown
+    bool readerFinished = false;
+    const bool usesHex;
+
+    // Keeps the lexer's peek at the byte after a window inside the buffer
+    static constexpr size_t bufferPadding = 8;
+
+  public:
+    // _reader : Provides the input
+    // _totalSize (Optional) : The input's size in bytes, used in GetProgress
+    // _chunkSize (Optional) : The number of bytes requested from the reader at a time
+    LexerStream(Reader _reader,
+                unsigned long long _totalSize = 0,
+                size_t _chunkSize = 0x10000,
+                bool _useHex = false) : reader(std::move(_reader)),
+                                        chunkSize(_chunkSize ? _chunkSize : 1),
+                                        buffer(chunkSize + bufferPadding),
+                                        totalSize(_totalSize),
+                                        usesHex(_useHex)
+    {}
+
+    // Reads from the file's current position, the file must stay open while the stream is in use
+    LexerStream(FILE* _file, size_t _chunkSize = 0x10000, bool _useHex = false)
+      : LexerStream([_file](char* _buffer, size_t _size) { return fread(_buffer, 1, _size, _file); },
+                    GetRemainingFileSize(_file),
+                    _chunkSize,
+                    _useHex)
+    {}
+
+    //=========================
+    // Token retrieval
+    //=========================
+
+    // See Lexer::NextToken
+    YTools::LexerToken NextToken(bool _expectHex = false, bool _includeWhitespace = false)
+    {
+      return Lex([&](YTools::Lexer& _lexer) { return _lexer.NextToken(_expectHex, _includeWhitespace); });
+    }
+
+    // See Lexer::Read
+    YTools::LexerToken Read(unsigned long long _count)
+    {
+      return Lex([&](YTools::Lexer& _lexer) { return _lexer.Read(_count); });
+    }
+
+    // See Lexer::ReadTo
+    YTools::LexerToken ReadTo(char _key)
+    {
+      return Lex([&](YTools::Lexer& _lexer) { return _lexer.ReadTo(_key); });
+    }
+
+    // See Lexer::ReadThrough
+    YTools::LexerToken ReadThrough(char _key)
+    {
+      return Lex([&](YTools::Lexer& _lexer) { return _lexer.ReadThrough(_key); });
+    }
+
+    // See Lexer::ReadThrough
+    YTools::LexerToken ReadThrough(std::string_view _key)
+    {
+      return Lex([&](YTools::Lexer& _lexer) { return _lexer.ReadThrough(_key); });
+    }
+
+    // See Lexer::ReadToFirst
+    unsigned int ReadToFirst(const YTools::LexerKeySet& _keys, YTools::LexerToken* _outToken = nullptr)
+    {
+      unsigned int keyFound = -1;
+      YTools::LexerToken token = Lex([&](YTools::Lexer& _lexer) {
+        YTools::LexerToken read;
+        keyFound = _lexer.ReadToFirst(_keys, &read);
+        return read;
+      });
+
+      if (_outToken != nullptr)
+        *_outToken = std::move(token);
+
+      return keyFound;
+    }
+
+    // See Lexer::ReadThroughFirst
+    unsigned int ReadThroughFirst(const YTools::LexerKeySet& _keys, YTools::LexerToken* _outToken = nullptr)
+    {
+      unsigned int keyFound = -1;
+      YTools::LexerToken token = Lex([&](YTools::Lexer& _lexer) {
+        YTools::LexerToken read;
+        keyFound = _lexer.ReadThroughFirst(_keys, &read);
+        return read;
+      });
+
+      if (_outToken != nullptr)
+        *_outToken = std::move(token);
+
+      return keyFound;
+    }
+
+    // Returns the percentage (0-1) of the input that has been read past
+    // > Always 0 when the input's size is unknown, see GetBytesConsumed
+    float GetProgress() const
+    {
+      if (totalSize == 0)
+        return 0.0f;
+
+      return (float)((double)consumed / (double)totalSize);
+    }
+
+    unsigned long long GetBytesConsumed() const
+    {
+      return consumed;
+    }
+
+    // Returns true once the reader is exhausted and every buffered byte has been read
+    bool CompletedStream()
+    {
+      if (head == filled && !readerFinished)
+        Refill();
+
+      return head == filled && readerFinished;
+    }
+
+  private:
+    static unsigned long long GetRemainingFileSize(FILE* _file)
+    {
+      long position = ftell(_file);
+      if (position < 0 || fseek(_file, 0, SEEK_END) != 0)
+        return 0;
+
+      long end = ftell(_file);
+      fseek(_file, position, SEEK_SET);
+
+      return (end > position) ? (unsigned long long)(end - position) : 0;
+    }
+
+    // Runs the operation on a lexer over the buffered bytes
+    // > Results that reach the end of the buffer may continue into the next chunk, so the buffer is
+    //   refilled and the operation is repeated from the same position until they end inside the buffer
+    template <typename Operation>
+    YTools::LexerToken Lex(Operation _operation)
+    {
+      while (true)
       {
-        switch (_char)
+        const char* window = buffer.data() + head;
+        const size_t available = filled - head;
+
+        YTools::Lexer lexer(window, available, usesHex);
+        YTools::LexerToken token = _operation(lexer);
+
+        size_t used = (size_t)(lexer.charStream - window);
+        if (used > available)
+          used = available;
+
+        if (used + YTools::Lexer::tokenLookahead < available || readerFinished)
         {
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-        case '.':
-          return true;
-        default:
-          return false;
+          Consume(used);
+          return token;
         }
+
+        // Whitespace skipped before the token can not be a part of it
+        if (token.start > window)
+          Consume((size_t)(token.start - window));
+
+        Refill();
       }
     }
 
-    bool IsString(char _char)
+    void Consume(size_t _count)
     {
-      switch (_char)
-      {
-      case '0': case '1': case '2': case '3': case '4':
-      case '5': case '6': case '7': case '8': case '9':
-      case 'A': case 'B': case 'C': case 'D': case 'E':
-      case 'F': case 'G': case 'H': case 'I': case 'J':
-      case 'K': case 'L': case 'M': case 'N': case 'O':
-      case 'P': case 'Q': case 'R': case 'S': case 'T':
-      case 'U': case 'V': case 'W': case 'X': case 'Y': case 'Z':
-      case '_': case '-':
-      case 'a': case 'b': case 'c': case 'd': case 'e':
-      case 'f': case 'g': case 'h': case 'i': case 'j':
-      case 'k': case 'l': case 'm': case 'n': case 'o':
-      case 'p': case 'q': case 'r': case 's': case 't':
-      case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
-        return true;
-      default:
-        return false;
-      }
+      head += _count;
+      consumed += _count;
     }
 
+    // Moves the unread bytes to the front of the buffer and reads another chunk after them
+    void Refill()
+    {
+      if (readerFinished)
+        return;
+
+      if (head > 0)
+      {
+        memmove(buffer.data(), buffer.data() + head, filled - head);
+        filled -= head;
+        head = 0;
+      }
+
+      // Only grows beyond one chunk while a single token is longer than the buffer
+      if (buffer.size() < filled + chunkSize + bufferPadding)
+        buffer.resize(filled + chunkSize + bufferPadding);
 
-  }; // Lexer
+      size_t read = reader(buffer.data() + filled, chunkSize);
+      filled += read;
+
+      if (read == 0)
+        readerFinished = true;
+    }
+  }; // LexerStream
 } // namespace YTools
 
 #endif // !define YTOOLS_LEXER_H_
@@ -3,9 +3,32 @@
 #define YTOOLS_LOGGER_H_
 
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif // Platforms
 
 namespace Ytools {
 
@@ -18,9 +41,52 @@ enum LogTypes
   Log_Type_Fatal
 };
 
+//=========================
+// Levels
+//=========================
+// Messages below the compile-time minimum are removed by the log macros, arguments included
+// > Define YTOOLS_LOG_MIN_LEVEL as a LogTypes value (0 Info - 4 Fatal), defaults to Info with _DEBUG, Error without
+// Messages below the runtime level are discarded before any formatting
+
+#ifndef YTOOLS_LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define YTOOLS_LOG_MIN_LEVEL 0
+#else
+#define YTOOLS_LOG_MIN_LEVEL 3
+#endif // _DEBUG
+#endif // YTOOLS_LOG_MIN_LEVEL
+
+constexpr LogTypes logMinimumLevel = (LogTypes)YTOOLS_LOG_MIN_LEVEL;
+
+inline std::atomic<int>& LoggerGetRuntimeLevel()
+{
+  static std::atomic<int> level { Log_Type_Info };
+  return level;
+}
+
+// Discards later messages below _level, levels below the compile-time minimum stay removed
+// > Clamped to Log_Type_Fatal, fatal messages are never discarded at runtime
+inline void LoggerSetLevel(LogTypes _level)
+{
+  LoggerGetRuntimeLevel().store(_level < Log_Type_Fatal ? _level : Log_Type_Fatal, std::memory_order_relaxed);
+}
+
+inline LogTypes LoggerGetLevel()
+{
+  return (LogTypes)LoggerGetRuntimeLevel().load(std::memory_order_relaxed);
+}
+
+inline bool LoggerIsEnabled(LogTypes _type)
+{
+  return _type >= logMinimumLevel && _type >= LoggerGetRuntimeLevel().load(std::memory_order_relaxed);
+}
+
+//=========================
+// Console
+//=========================
+
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
-#include <windows.h>
-void PrintToConsole(const char* _message, unsigned int _color)
+inline void PrintToConsole(const char* _message, unsigned int _color)
 {
   //                        Info , Debug, Warning, Error , Fatal
   //                        White, Cyan , Yellow , Red   , White-on-Red
@@ -30,65 +96,1739 @@ void PrintToConsole(const char* _message, unsigned int _color)
   SetConsoleTextAttribute(console, colors[_color]);
   OutputDebugStringA(_message);
   unsigned long long length = strlen(_message);
-  LPDWORD written = 0;
-  WriteConsoleA(console, _message, (DWORD)length, written, 0);
+  DWORD written = 0;
+  WriteConsoleA(console, _message, (DWORD)length, &written, 0);
   SetConsoleTextAttribute(console, 0xf);
 }
+#else
+// Writes every byte, retrying short writes
+inline bool LoggerWriteAll(int _file, const char* _text, size_t _length)
+{
+  while (_length > 0)
+  {
+    ssize_t written = write(_file, _text, _length);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+
+    _text += written;
+    _length -= (size_t)written;
+  }
+  return true;
+}
+
+// Colors are ANSI escape sequences, left out when stdout is not a terminal
+inline void PrintToConsole(const char* _message, unsigned int _color)
+{
+  //                         Info     , Debug    , Warning  , Error   , Fatal
+  //                         White    , Cyan     , Yellow   , Red     , White-on-Red
+  const char* colors[] = { "\x1b[97m", "\x1b[96m", "\x1b[93m", "\x1b[31m", "\x1b[97;41m" };
+  const char* reset = "\x1b[0m";
+  static const bool isTerminal = isatty(STDOUT_FILENO) == 1;
+
+  const size_t length = strlen(_message);
+  if (!isTerminal)
+  {
+    LoggerWriteAll(STDOUT_FILENO, _message, length);
+    return;
+  }
+
+  // Color, message, and reset in one call
+  struct iovec parts[3] = {
+    { (void*)colors[_color], strlen(colors[_color]) },
+    { (void*)_message, length },
+    { (void*)reset, strlen(reset) }
+  };
+
+  ssize_t written;
+  do
+  {
+    written = writev(STDOUT_FILENO, parts, 3);
+  } while (written < 0 && errno == EINTR);
+
+  if (written < 0)
+    return;
+
+  // Finish a short write part by part
+  size_t skip = (size_t)written;
+  for (const struct iovec& part : parts)
+  {
+    if (skip >= part.iov_len)
+    {
+      skip -= part.iov_len;
+      continue;
+    }
+
+    LoggerWriteAll(STDOUT_FILENO, (const char*)part.iov_base + skip, part.iov_len - skip);
+    skip = 0;
+  }
+}
+#endif // Platforms
+
+//=========================
+// Sinks
+//=========================
+// Destinations for finished lines, messages go to every added sink
+// > With no sinks added, messages are printed to the console
+// > Calls are serialized by the logger, a sink does not need its own locking
+// > Sinks are called with the logger's output locked, so from inside a sink, logged messages are discarded,
+//   and LoggerFlush, LoggerFlushWritten, LoggerAddSink, and LoggerClearSinks return without doing anything
+
+class LogSink
+{
+public:
+  virtual ~LogSink() = default;
+
+  // _text : One or more complete lines of _type, followed by '\0'
+  virtual void Write(LogTypes _type, const char* _text, size_t _length) = 0;
+
+  // Writes any buffered text to its destination
+  virtual void Flush() {}
+
+  // Called periodically by the async consumer thread, lets buffered sinks honor their flush interval while idle
+  virtual void Poll() {}
+};
+
+// Prints to the console in each message type's color
+class LogConsoleSink : public LogSink
+{
+public:
+  void Write(LogTypes _type, const char* _text, size_t _length) override
+  {
+    (void)_length;
+    PrintToConsole(_text, _type);
+  }
+};
+
+// Appends lines to a file, holding them in memory until the buffer fills or the flush interval passes
+// > Fatal messages are written immediately
+// > In synchronous mode, held text is written by the first line after the interval, Flush, or destruction
+class LogFileSink : public LogSink
+{
+public:
+  // _path : Created if missing, appended to otherwise
+  // _bufferSize (Optional) : Bytes held before writing to the file
+  // _flushInterval (Optional) : Longest time text is held, 0 writes every line as it arrives
+  LogFileSink(const char* _path,
+              size_t _bufferSize = 0x100000,
+              std::chrono::milliseconds _flushInterval = std::chrono::milliseconds(1000))
+    : path(_path), bufferSize(_bufferSize), flushInterval(_flushInterval),
+      buffer(new char[_bufferSize]), lastFlush(std::chrono::steady_clock::now())
+  {
+    Open();
+  }
+
+  ~LogFileSink() override
+  {
+    Flush();
+    Close();
+  }
+
+  LogFileSink(const LogFileSink&) = delete;
+  LogFileSink& operator=(const LogFileSink&) = delete;
+
+  bool IsOpen() const
+  {
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+    return file != INVALID_HANDLE_VALUE;
+#else
+    return file >= 0;
+#endif // Platforms
+  }
+
+  void Write(LogTypes _type, const char* _text, size_t _length) override
+  {
+    if (_length > bufferSize - used)
+      Flush();
+
+    // Too large to hold, write it straight through
+    if (_length > bufferSize)
+      WriteToFile(_text, _length);
+    else
+    {
+      memcpy(buffer.get() + used, _text, _length);
+      used += _length;
+    }
+
+    if (_type == Log_Type_Fatal || flushInterval.count() == 0)
+      Flush();
+    else
+      Poll();
+  }
+
+  void Flush() override
+  {
+    if (used > 0)
+      WriteToFile(buffer.get(), used);
+
+    used = 0;
+    lastFlush = std::chrono::steady_clock::now();
+  }
+
+  void Poll() override
+  {
+    if (used > 0 && std::chrono::steady_clock::now() - lastFlush >= flushInterval)
+      Flush();
+  }
+
+protected:
+  // Every write to the file passes through here, with the file's size afterward in fileSize
+  virtual void WriteToFile(const char* _text, size_t _length)
+  {
+    if (!IsOpen())
+      return;
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+    DWORD written = 0;
+    WriteFile(file, _text, (DWORD)_length, &written, NULL);
+    fileSize += written;
+#else
+    if (LoggerWriteAll(file, _text, _length))
+      fileSize += _length;
+#endif // Platforms
+  }
+
+  bool Open()
+  {
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+    file = CreateFileA(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size = {};
+    if (file != INVALID_HANDLE_VALUE)
+      GetFileSizeEx(file, &size);
+    fileSize = (size_t)size.QuadPart;
+#else
+    file = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    off_t size = (file >= 0) ? lseek(file, 0, SEEK_END) : 0;
+    fileSize = (size > 0) ? (size_t)size : 0;
+#endif // Platforms
+    return IsOpen();
+  }
+
+  void Close()
+  {
+    if (!IsOpen())
+      return;
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+    CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+#else
+    close(file);
+    file = -1;
+#endif // Platforms
+  }
+
+  std::string path;
+  size_t fileSize = 0;
+
+private:
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+  HANDLE file = INVALID_HANDLE_VALUE;
+#else
+  int file = -1;
 #endif // Platforms
 
+  const size_t bufferSize;
+  const std::chrono::milliseconds flushInterval;
+  std::unique_ptr<char[]> buffer;
+  size_t used = 0;
+  std::chrono::steady_clock::time_point lastFlush;
+};
+
+// A file sink that moves to a new file once the current one reaches a size
+// > The current file is always _path, older files are _path.1 (newest) to _path.<_maxFiles>, the oldest is removed
+// > Files are checked after each write to disk, so one can exceed the limit by up to a buffer
+class LogRotatingFileSink : public LogFileSink
+{
+public:
+  // _maxFileSize : Bytes written before rotating
+  // _maxFiles : Older files kept besides the current one
+  LogRotatingFileSink(const char* _path,
+                      size_t _maxFileSize,
+                      unsigned int _maxFiles,
+                      size_t _bufferSize = 0x100000,
+                      std::chrono::milliseconds _flushInterval = std::chrono::milliseconds(1000))
+    : LogFileSink(_path, _bufferSize, _flushInterval), maxFileSize(_maxFileSize), maxFiles(_maxFiles)
+  {}
+
+protected:
+  void WriteToFile(const char* _text, size_t _length) override
+  {
+    LogFileSink::WriteToFile(_text, _length);
+
+    if (fileSize >= maxFileSize)
+      Rotate();
+  }
+
+private:
+  void Rotate()
+  {
+    Close();
+
+    if (maxFiles == 0)
+      remove(path.c_str());
+    else
+    {
+      remove(RotatedPath(maxFiles).c_str());
+      for (unsigned int i = maxFiles - 1; i > 0; i--)
+      {
+        rename(RotatedPath(i).c_str(), RotatedPath(i + 1).c_str());
+      }
+      rename(path.c_str(), RotatedPath(1).c_str());
+    }
+
+    Open();
+  }
+
+  std::string RotatedPath(unsigned int _index) const
+  {
+    return path + "." + std::to_string(_index);
+  }
+
+  const size_t maxFileSize;
+  const unsigned int maxFiles;
+};
+
+// Sink registration =====
+
+// Whether the thread is calling a sink, see LogSink
+inline bool& LoggerInSink()
+{
+  thread_local bool inSink = false;
+  return inSink;
+}
+
+// Marks the thread as calling a sink while in scope
+struct LoggerSinkScope
+{
+  LoggerSinkScope()
+  {
+    LoggerInSink() = true;
+  }
+
+  ~LoggerSinkScope()
+  {
+    LoggerInSink() = false;
+  }
+};
+
+// The active sinks and the lock serializing every write to them
+struct LoggerOutput
+{
+  std::mutex mutex;
+  std::vector<std::shared_ptr<LogSink>> sinks;
+
+  // > The caller must hold mutex
+  void Write(LogTypes _type, const char* _text, size_t _length)
+  {
+    LoggerSinkScope scope;
+    if (sinks.empty())
+    {
+      PrintToConsole(_text, _type);
+      return;
+    }
+
+    for (const std::shared_ptr<LogSink>& sink : sinks)
+    {
+      sink->Write(_type, _text, _length);
+    }
+  }
+
+  // > The caller must hold mutex
+  void Flush()
+  {
+    LoggerSinkScope scope;
+    for (const std::shared_ptr<LogSink>& sink : sinks)
+    {
+      sink->Flush();
+    }
+  }
+
+  // > The caller must hold mutex
+  void Poll()
+  {
+    LoggerSinkScope scope;
+    for (const std::shared_ptr<LogSink>& sink : sinks)
+    {
+      sink->Poll();
+    }
+  }
+};
+
+inline LoggerOutput& LoggerGetOutput()
+{
+  static LoggerOutput output;
+  return output;
+}
+
+// Adds a destination for every later message
+// > Replaces the default console output, add a LogConsoleSink to keep it
+inline void LoggerAddSink(std::shared_ptr<LogSink> _sink)
+{
+  if (LoggerInSink())
+    return;
+
+  LoggerOutput& output = LoggerGetOutput();
+  std::lock_guard<std::mutex> lock(output.mutex);
+  output.sinks.push_back(std::move(_sink));
+}
+
+// Flushes and removes every sink, returning to console output
+inline void LoggerClearSinks()
+{
+  if (LoggerInSink())
+    return;
+
+  LoggerOutput& output = LoggerGetOutput();
+  std::lock_guard<std::mutex> lock(output.mutex);
+  output.Flush();
+  output.sinks.clear();
+}
+
+//=========================
+// Line prefixes
+//=========================
+// Lines start with their time (UTC), thread, and level: "[12:34:56.789012] [4242] [WARN ] "
+// > Taken by the calling thread, formatted by whichever thread writes the line
+// > LoggerAssembleMessage writes raw text without a prefix
+
+enum LogPrefixFlags
+{
+  Log_Prefix_None = 0,
+  Log_Prefix_Time = 1,
+  Log_Prefix_Thread = 2,
+  Log_Prefix_Level = 4,
+  Log_Prefix_All = Log_Prefix_Time | Log_Prefix_Thread | Log_Prefix_Level
+};
+
+constexpr size_t logPrefixMaxLength = 0x40;
+
+inline std::atomic<unsigned int>& LoggerGetPrefixFlags()
+{
+  static std::atomic<unsigned int> flags { Log_Prefix_All };
+  return flags;
+}
+
+// _flags : Combination of LogPrefixFlags
+inline void LoggerSetPrefixes(unsigned int _flags)
+{
+  LoggerGetPrefixFlags().store(_flags, std::memory_order_relaxed);
+}
+
+// Monotonic nanoseconds, cheap enough to take on every message
+inline int64_t LoggerTimestamp()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Converts a LoggerTimestamp to nanoseconds since the Unix epoch
+// > Calibrated against the wall clock once, so adjustments to the wall clock afterward are not followed
+inline int64_t LoggerWallTime(int64_t _timestamp)
+{
+  static const int64_t offset =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()
+    - LoggerTimestamp();
+  return _timestamp + offset;
+}
+
+// The OS's ID for the calling thread, looked up once per thread
+inline uint32_t LoggerThreadId()
+{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+  thread_local const uint32_t id = (uint32_t)GetCurrentThreadId();
+#elif defined(__linux__)
+  thread_local const uint32_t id = (uint32_t)syscall(SYS_gettid);
+#else
+  static std::atomic<uint32_t> nextId { 1 };
+  thread_local const uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+#endif // Platforms
+  return id;
+}
+
+// Writes _value in decimal, zero-padded to _width digits
+inline char* LoggerWriteDigits(char* _out, uint64_t _value, unsigned int _width)
+{
+  char digits[20];
+  unsigned int count = 0;
+  do
+  {
+    digits[count++] = (char)('0' + _value % 10);
+    _value /= 10;
+  } while (_value > 0);
+
+  while (count < _width)
+  {
+    digits[count++] = '0';
+  }
+
+  while (count > 0)
+  {
+    *_out++ = digits[--count];
+  }
+  return _out;
+}
+
+// Writes the prefix of the enabled flags into _outText, which holds at least logPrefixMaxLength bytes
+// Returns the prefix's length
+inline size_t LoggerFormatPrefix(char* _outText, unsigned int _flags, LogTypes _type, int64_t _timestamp, uint32_t _thread)
+{
+  static const char* levels[] = { "INFO ", "DEBUG", "WARN ", "ERROR", "FATAL" };
+  char* out = _outText;
+
+  if (_flags & Log_Prefix_Time)
+  {
+    const uint64_t wall = (uint64_t)LoggerWallTime(_timestamp);
+    const uint64_t daySeconds = (wall / 1000000000) % 86400;
+
+    *out++ = '[';
+    out = LoggerWriteDigits(out, daySeconds / 3600, 2);
+    *out++ = ':';
+    out = LoggerWriteDigits(out, daySeconds / 60 % 60, 2);
+    *out++ = ':';
+    out = LoggerWriteDigits(out, daySeconds % 60, 2);
+    *out++ = '.';
+    out = LoggerWriteDigits(out, wall / 1000 % 1000000, 6);
+    *out++ = ']';
+    *out++ = ' ';
+  }
+
+  if (_flags & Log_Prefix_Thread)
+  {
+    *out++ = '[';
+    out = LoggerWriteDigits(out, _thread, 1);
+    *out++ = ']';
+    *out++ = ' ';
+  }
+
+  if (_flags & Log_Prefix_Level)
+  {
+    *out++ = '[';
+    memcpy(out, levels[_type], 5);
+    out += 5;
+    *out++ = ']';
+    *out++ = ' ';
+  }
+
+  return (size_t)(out - _outText);
+}
+
+// Thread buffers =====
+
+// Longest message text, longer messages are truncated
+constexpr size_t logMaxMessageLength = 0x8000;
+
+// Each thread formats into its own buffer, grown as needed up to logMaxMessageLength
+struct LoggerThreadBuffer
+{
+  static constexpr size_t capacity = logPrefixMaxLength + logMaxMessageLength + 2;
+
+  std::unique_ptr<char[]> data { new char[0x1000] };
+  size_t size = 0x1000;
+
+  void Reserve(size_t _size)
+  {
+    if (_size <= size)
+      return;
+
+    size = (_size < capacity) ? _size : capacity;
+    data.reset(new char[size]);
+  }
+};
+
+inline LoggerThreadBuffer& LoggerGetThreadBuffer()
+{
+  thread_local LoggerThreadBuffer buffer;
+  return buffer;
+}
+
+//=========================
+// Async backend
+//=========================
+// Producers format into a slot of a bounded lock-free ring, a background thread writes the slots to the sinks
+// > Started by LoggerStartAsync, messages are printed synchronously until then
+
+// What producers do when every slot of the ring is in use
+enum LogOverflow
+{
+  Log_Overflow_Drop, // Discard the message, the number dropped is reported by the consumer thread
+  Log_Overflow_Block // Wait for the consumer thread to free a slot
+};
+
+struct LogAsyncConfig
+{
+  unsigned int capacity = 1024; // Records held at once, rounded up to a power of 2 (0x800 bytes each, longer messages take several)
+  LogOverflow overflow = Log_Overflow_Drop;
+};
+
+// Formats a deferred record's raw arguments into _outText, see LoggerRecordDeferred
+typedef void (*LogDecoder)(const char* _format, const unsigned char* _arguments, char* _outText, size_t _size);
+
+// A message waiting in the ring
+// > Messages longer than one record continue in the following records, only the first's header is used
+struct LogRecord
+{
+  LogTypes type;
+  LogDecoder decode;  // nullptr if the message is already formatted
+  const char* format; // Deferred records only
+  int64_t timestamp;
+  uint32_t thread;
+  unsigned short span;   // Records holding the message, including this one
+  unsigned short length; // Bytes of formatted text in this record
+  bool prefixed;         // Whether the line gets the time, thread, and level prefix
+  char message[0x800]; // The formatted message, or a deferred record's raw arguments
+};
+
+// Bounded multi-producer, single-consumer ring, after Dmitry Vyukov's bounded queue
+// > A slot's sequence is its position while free, position + 1 while holding a record
+struct LoggerAsyncState
+{
+  struct Slot
+  {
+    std::atomic<size_t> sequence;
+    LogRecord record;
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  size_t mask = 0;
+  LogOverflow overflow = Log_Overflow_Drop;
+
+  static constexpr size_t batchSize = 0x10000; // Larger than any message, holds the combined text of one write
+  std::unique_ptr<char[]> batch;
+
+  std::atomic<size_t> enqueuePosition { 0 };
+  std::atomic<size_t> completedPosition { 0 }; // Records written by the consumer
+  size_t dequeuePosition = 0;                  // Consumer thread only
+  std::atomic<unsigned long long> dropped { 0 };
+
+  std::atomic<bool> running { false };
+  std::atomic<bool> consumerWaiting { false };
+  std::mutex wakeMutex;
+  std::condition_variable wake;
+  std::thread consumer;
+
+  ~LoggerAsyncState()
+  {
+    Stop();
+  }
+
+  LogRecord& RecordAt(size_t _position)
+  {
+    return slots[_position & mask].record;
+  }
+
+  // Returns the first of _count consecutive free records to fill, nullptr if the ring is full
+  // > Slots are freed in order, so the last being free means every one before it is too
+  LogRecord* Claim(size_t _count, size_t* _outPosition)
+  {
+    size_t position = enqueuePosition.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+      Slot& last = slots[(position + _count - 1) & mask];
+      long long difference = (long long)last.sequence.load(std::memory_order_acquire) - (long long)(position + _count - 1);
+
+      if (difference == 0)
+      {
+        if (enqueuePosition.compare_exchange_weak(position, position + _count, std::memory_order_relaxed))
+        {
+          *_outPosition = position;
+          return &RecordAt(position);
+        }
+      }
+      else if (difference < 0)
+        return nullptr;
+      else
+        position = enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Claims _count records, applying the overflow behavior when the ring is full
+  // Returns nullptr if the message was dropped
+  LogRecord* Acquire(LogTypes _type, size_t _count, size_t* _outPosition)
+  {
+    LogRecord* record = Claim(_count, _outPosition);
+
+    // Fatal messages are never dropped
+    while (record == nullptr && (overflow == Log_Overflow_Block || _type == Log_Type_Fatal))
+    {
+      Wake();
+      std::this_thread::yield();
+      record = Claim(_count, _outPosition);
+    }
+
+    if (record == nullptr)
+      dropped.fetch_add(1, std::memory_order_relaxed);
+
+    return record;
+  }
+
+  // Hands _count filled records to the consumer thread
+  // > The first is published last, the consumer reads the rest once it sees the first
+  void Publish(size_t _position, size_t _count = 1)
+  {
+    for (size_t i = _count - 1; i > 0; i--)
+    {
+      slots[(_position + i) & mask].sequence.store(_position + i + 1, std::memory_order_relaxed);
+    }
+    slots[_position & mask].sequence.store(_position + 1, std::memory_order_release);
+
+    // Only the producer that clears the flag wakes the consumer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumerWaiting.load(std::memory_order_relaxed) && consumerWaiting.exchange(false, std::memory_order_relaxed))
+      Wake();
+  }
+
+  void Wake()
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+  }
+
+  bool HasRecord() const
+  {
+    return slots[dequeuePosition & mask].sequence.load(std::memory_order_acquire) == dequeuePosition + 1;
+  }
+
+  bool Start(const LogAsyncConfig& _config)
+  {
+    if (running.load())
+      return false;
+
+    size_t capacity = 2;
+    while (capacity < _config.capacity)
+      capacity <<= 1;
+
+    slots.reset(new Slot[capacity]);
+    batch.reset(new char[batchSize + 1]);
+    for (size_t i = 0; i < capacity; i++)
+    {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    mask = capacity - 1;
+    overflow = _config.overflow;
+    enqueuePosition.store(0);
+    completedPosition.store(0);
+    dequeuePosition = 0;
+    dropped.store(0);
+
+    running.store(true);
+    consumer = std::thread([this] { Consume(); });
+    return true;
+  }
+
+  // Writes every queued record, then joins the consumer thread
+  // > Must not be called while other threads are logging
+  void Stop()
+  {
+    if (!running.exchange(false))
+      return;
+
+    Wake();
+    consumer.join();
+  }
+
+  // Consumer thread =====
+
+  // Writes every published record in order, freeing their slots
+  // > Consecutive records of the same type are combined into one sink write
+  void Drain()
+  {
+    size_t batchLength = 0;
+    LogTypes batchType = Log_Type_Info;
+    const unsigned int prefixFlags = LoggerGetPrefixFlags().load(std::memory_order_relaxed);
+
+    while (HasRecord())
+    {
+      LogRecord& record = RecordAt(dequeuePosition);
+      const LogTypes type = record.type;
+      const size_t span = record.span;
+      const bool isDeferred = record.decode != nullptr;
+
+      char decoded[0x800];
+      size_t length = 0;
+      if (isDeferred)
+      {
+        record.decode(record.format, (const unsigned char*)record.message, decoded, sizeof(decoded));
+        length = strlen(decoded);
+      }
+      else
+      {
+        for (size_t i = 0; i < span; i++)
+        {
+          length += RecordAt(dequeuePosition + i).length;
+        }
+      }
+
+      char prefix[logPrefixMaxLength];
+      size_t prefixLength = 0;
+      if (record.prefixed)
+        prefixLength = LoggerFormatPrefix(prefix, prefixFlags, type, record.timestamp, record.thread);
+
+      if (batchLength > 0 && (type != batchType || batchLength + prefixLength + length >= batchSize))
+      {
+        WriteBatch(batchLength, batchType);
+        batchLength = 0;
+      }
+
+      memcpy(batch.get() + batchLength, prefix, prefixLength);
+      batchLength += prefixLength;
+      batchType = type;
+
+      if (isDeferred)
+      {
+        memcpy(batch.get() + batchLength, decoded, length);
+        batchLength += length;
+      }
+
+      // The slots are free once copied, the records count as completed once written
+      // > The first record may be reused as soon as it is freed, its header must not be read afterward
+      for (size_t i = 0; i < span; i++)
+      {
+        Slot& slot = slots[dequeuePosition & mask];
+        if (!isDeferred)
+        {
+          memcpy(batch.get() + batchLength, slot.record.message, slot.record.length);
+          batchLength += slot.record.length;
+        }
+
+        slot.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+        dequeuePosition++;
+      }
+    }
 
-void LoggerAssembleMessage(LogTypes _type, const char* _message, ...)
+    if (batchLength > 0)
+      WriteBatch(batchLength, batchType);
+  }
+
+  void WriteBatch(size_t _length, LogTypes _type)
+  {
+    batch[_length] = '\0';
+    {
+      LoggerOutput& output = LoggerGetOutput();
+      std::lock_guard<std::mutex> lock(output.mutex);
+      output.Write(_type, batch.get(), _length);
+    }
+    completedPosition.store(dequeuePosition, std::memory_order_release);
+  }
+
+  void Consume()
+  {
+    while (true)
+    {
+      Drain();
+
+      unsigned long long droppedCount = dropped.exchange(0);
+      if (droppedCount)
+      {
+        char report[0x80];
+        int length = snprintf(report, sizeof(report), "[Ytools] %llu log messages dropped\n", droppedCount);
+
+        LoggerOutput& output = LoggerGetOutput();
+        std::lock_guard<std::mutex> lock(output.mutex);
+        output.Write(Log_Type_Warning, report, (size_t)length);
+      }
+
+      {
+        LoggerOutput& output = LoggerGetOutput();
+        std::lock_guard<std::mutex> lock(output.mutex);
+        output.Poll();
+      }
+
+      if (!running.load())
+        break;
+
+      // Poll briefly first, putting the consumer to sleep and waking it costs producers far more
+      for (unsigned int spin = 0; spin < 64 && !HasRecord(); spin++)
+      {
+        std::this_thread::yield();
+      }
+      if (HasRecord())
+        continue;
+
+      // Sleep until a producer publishes, re-checking after announcing to not miss a record
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      consumerWaiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (!HasRecord() && running.load())
+        wake.wait_for(lock, std::chrono::milliseconds(100));
+
+      consumerWaiting.store(false, std::memory_order_relaxed);
+    }
+
+    // Records published after the last check
+    Drain();
+  }
+};
+
+inline LoggerAsyncState& LoggerGetAsyncState()
+{
+  // The output is constructed first so it outlives the state, whose destructor drains into it
+  LoggerGetOutput();
+  static LoggerAsyncState state;
+  return state;
+}
+
+// Starts the consumer thread, later messages are written asynchronously
+// Returns false if it is already running
+inline bool LoggerStartAsync(const LogAsyncConfig& _config = {})
+{
+  return LoggerGetAsyncState().Start(_config);
+}
+
+inline void LoggerReportAllSuppressed();
+
+// Writes every queued message and returns to synchronous printing
+// > Pending suppressed-message counts are queued first, see LoggerReportAllSuppressed
+// > Must not be called while other threads are logging
+inline void LoggerStopAsync()
+{
+  LoggerReportAllSuppressed();
+  LoggerGetAsyncState().Stop();
+}
+
+// Waits until every message queued before the call has been written, then flushes every sink
+inline void LoggerFlushWritten()
+{
+  // A sink would wait on the consumer thread calling it, or lock the output again
+  if (LoggerInSink())
+    return;
+
+  LoggerAsyncState& state = LoggerGetAsyncState();
+  if (state.running.load(std::memory_order_acquire))
+  {
+    const size_t target = state.enqueuePosition.load(std::memory_order_acquire);
+    while (state.completedPosition.load(std::memory_order_acquire) < target)
+    {
+      state.Wake();
+      std::this_thread::yield();
+    }
+  }
+
+  LoggerOutput& output = LoggerGetOutput();
+  std::lock_guard<std::mutex> lock(output.mutex);
+  output.Flush();
+}
+
+// Reports pending suppressed-message counts, then waits for every queued message and flushes every sink
+inline void LoggerFlush()
+{
+  // Reporting from a sink would take the counts and discard them
+  if (LoggerInSink())
+    return;
+
+  LoggerReportAllSuppressed();
+  LoggerFlushWritten();
+}
+
+// Formats into a fixed buffer, appending a newline when _line is true
+// > The newline is kept when the message is truncated
+inline void LoggerFormat(char* _outText, size_t _size, bool _line, const char* _message, va_list _args)
+{
+  int written = vsnprintf(_outText, _size - _line, _message, _args);
+
+  if (_line)
+  {
+    size_t end = (written < 0) ? 0 : ((size_t)written < _size - 2 ? (size_t)written : _size - 2);
+    _outText[end] = '\n';
+    _outText[end + 1] = '\0';
+  }
+}
+
+// Formats the message into the thread's buffer at _offset, appending a newline when _line is true
+// Returns the text's length from _offset
+// > _offset must not exceed logPrefixMaxLength
+// > The newline is kept when the message is truncated
+inline size_t LoggerFormat(LoggerThreadBuffer& _buffer, size_t _offset, bool _line, const char* _message, va_list _args)
+{
+  va_list retry;
+  va_copy(retry, _args);
+
+  int written = vsnprintf(_buffer.data.get() + _offset, _buffer.size - _offset - _line, _message, _args);
+  size_t length = (written < 0) ? 0 : (size_t)written;
+  if (length > logMaxMessageLength)
+    length = logMaxMessageLength;
+
+  // Grow the buffer once to fit, and format again
+  if (_offset + length + _line + 1 > _buffer.size)
+  {
+    _buffer.Reserve(_offset + length + _line + 1);
+    vsnprintf(_buffer.data.get() + _offset, _buffer.size - _offset - _line, _message, retry);
+  }
+  va_end(retry);
+
+  char* text = _buffer.data.get() + _offset;
+  if (_line)
+    text[length++] = '\n';
+  text[length] = '\0';
+  return length;
+}
+
+// Hands the _length bytes of text at _offset in the thread's buffer to the async ring or the sinks
+// > _offset must be logPrefixMaxLength, the prefix is placed right before the text
+inline void LoggerSubmit(LogTypes _type, bool _line, int64_t _timestamp, LoggerThreadBuffer& _buffer, size_t _offset, size_t _length)
+{
+  // A sink logging would lock the output again, or wait for ring space on the consumer thread calling it
+  if (LoggerInSink())
+    return;
+
+  char* text = _buffer.data.get() + _offset;
+
+  // Async =====
+  LoggerAsyncState& async = LoggerGetAsyncState();
+  if (async.running.load(std::memory_order_acquire))
+  {
+    // Split across as many records as needed, at most the whole ring
+    const size_t payload = sizeof(LogRecord::message);
+    size_t span = (_length + payload - 1) / payload;
+    if (span == 0)
+      span = 1;
+    if (span > async.mask + 1)
+    {
+      span = async.mask + 1;
+      _length = span * payload;
+      if (_line)
+        text[_length - 1] = '\n';
+    }
+
+    size_t position;
+    LogRecord* record = async.Acquire(_type, span, &position);
+
+    if (record != nullptr)
+    {
+      record->type = _type;
+      record->decode = nullptr;
+      record->timestamp = _timestamp;
+      record->thread = LoggerThreadId();
+      record->span = (unsigned short)span;
+      record->prefixed = _line;
+
+      for (size_t i = 0; i < span; i++)
+      {
+        LogRecord& part = async.RecordAt(position + i);
+        const size_t offset = i * payload;
+        const size_t partLength = (_length - offset < payload) ? _length - offset : payload;
+        memcpy(part.message, text + offset, partLength);
+        part.length = (unsigned short)partLength;
+      }
+
+      async.Publish(position, span);
+    }
+
+    if (_type == Log_Type_Fatal)
+      LoggerFlushWritten();
+    return;
+  }
+
+  // Synchronous =====
+  char prefix[logPrefixMaxLength];
+  size_t prefixLength = 0;
+  if (_line)
+    prefixLength = LoggerFormatPrefix(prefix, LoggerGetPrefixFlags().load(std::memory_order_relaxed), _type, _timestamp, LoggerThreadId());
+
+  text -= prefixLength;
+  memcpy(text, prefix, prefixLength);
+
+  LoggerOutput& output = LoggerGetOutput();
+  std::lock_guard<std::mutex> lock(output.mutex);
+  output.Write(_type, text, prefixLength + _length);
+}
+
+inline void LoggerWrite(LogTypes _type, bool _line, const char* _message, va_list _args)
 {
-  // Limit 2048 characters per message
-  const short length = 0x800;
-  char outMessage[0x800];
-  //memset(outMessage, 0, length);
+  const int64_t timestamp = LoggerTimestamp();
+  LoggerThreadBuffer& buffer = LoggerGetThreadBuffer();
+
+  const size_t length = LoggerFormat(buffer, logPrefixMaxLength, _line, _message, _args);
+  LoggerSubmit(_type, _line, timestamp, buffer, logPrefixMaxLength, length);
+}
+
+inline void LoggerAssembleMessage(LogTypes _type, const char* _message, ...)
+{
+  if (!LoggerIsEnabled(_type))
+    return;
 
   va_list args;
   va_start(args, _message);
-  vsnprintf(outMessage, length, _message, args);
+  LoggerWrite(_type, false, _message, args);
   va_end(args);
+}
 
-  PrintToConsole(outMessage, _type);
+// Formats the message and its newline into one buffer, written with a single sink write
+inline void LoggerAssembleLine(LogTypes _type, const char* _message, ...)
+{
+  if (!LoggerIsEnabled(_type))
+    return;
+
+  va_list args;
+  va_start(args, _message);
+  LoggerWrite(_type, true, _message, args);
+  va_end(args);
 }
 
-} // namespace Ytools
+//=========================
+// Deferred formatting
+//=========================
+// Define YTOOLS_LOG_DEFERRED to have the log macros copy their raw arguments into the async ring
+// > The consumer thread runs the formatting, the caller only copies bytes
+// > Strings are copied (truncated to fit the record), other arguments must be printf scalars
+// > A deferred message is formatted into one record's worth of text, 0x800 bytes
+// > Formats synchronously while the async backend is not running
 
-#ifdef _DEBUG
-#define LogInfo(message, ...)                                      \
-{                                                                  \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Info, message, __VA_ARGS__); \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Info, "\n");                 \
+namespace LoggerDeferred {
+
+template <typename Type>
+constexpr bool isString = std::is_same_v<Type, const char*> || std::is_same_v<Type, char*>;
+
+// The type an argument is stored and formatted as
+template <typename Type>
+using Stored = std::conditional_t<isString<std::decay_t<Type>>, const char*, std::decay_t<Type>>;
+
+constexpr uint32_t nullString = 0xffffffff;
+
+// Bytes an argument always takes, strings add their characters within the record's remaining space
+template <typename Type>
+constexpr size_t FixedSize()
+{
+  if constexpr (isString<Type>)
+    return sizeof(uint32_t) + 1;
+  else
+    return sizeof(Type);
 }
-   
-#define LogDebug(message, ...)                                      \
-{                                                                   \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Debug, message, __VA_ARGS__); \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Debug, "\n");                 \
+
+template <typename Type>
+inline void Encode(unsigned char*& _position, size_t& _stringSpace, Type _value)
+{
+  if constexpr (isString<Type>)
+  {
+    uint32_t length = nullString;
+    if (_value != nullptr)
+    {
+      size_t fullLength = strlen(_value);
+      length = (uint32_t)(fullLength < _stringSpace ? fullLength : _stringSpace);
+      _stringSpace -= length;
+    }
+
+    memcpy(_position, &length, sizeof(length));
+    _position += sizeof(length);
+
+    if (length != nullString)
+    {
+      memcpy(_position, _value, length);
+      _position += length;
+    }
+
+    *_position++ = '\0';
+  }
+  else
+  {
+    static_assert(std::is_arithmetic_v<Type> || std::is_pointer_v<Type> || std::is_enum_v<Type>,
+                  "Deferred log arguments must be strings or printf scalars");
+
+    memcpy(_position, &_value, sizeof(Type));
+    _position += sizeof(Type);
+  }
 }
 
-#define LogWarning(message, ...)                                   \
-{                                                                     \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Warning, message, __VA_ARGS__); \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Warning, "\n");                 \
+template <typename Type>
+inline Type Decode(const unsigned char*& _position)
+{
+  if constexpr (isString<Type>)
+  {
+    uint32_t length;
+    memcpy(&length, _position, sizeof(length));
+    _position += sizeof(length);
+
+    if (length == nullString)
+    {
+      _position++;
+      return nullptr;
+    }
+
+    const char* string = (const char*)_position;
+    _position += length + 1;
+    return string;
+  }
+  else
+  {
+    Type value;
+    memcpy(&value, _position, sizeof(Type));
+    _position += sizeof(Type);
+    return value;
+  }
+}
+
+inline void FormatLine(char* _outText, size_t _size, const char* _format, ...)
+{
+  va_list args;
+  va_start(args, _format);
+  LoggerFormat(_outText, _size, true, _format, args);
+  va_end(args);
+}
+
+// The LogDecoder instantiated for each argument list
+template <typename... Args>
+inline void Format(const char* _format, const unsigned char* _arguments, char* _outText, size_t _size)
+{
+  const unsigned char* position = _arguments;
+  (void)position;
+
+  // Braced initialization decodes the arguments in order
+  std::tuple<Args...> values { Decode<Args>(position)... };
+  std::apply([&](auto... _values) { FormatLine(_outText, _size, _format, _values...); }, values);
+}
+
+} // namespace LoggerDeferred
+
+// Queues the format string and a copy of the arguments, formatted as one line later by the consumer thread
+// _message : Must be a string literal (or otherwise outlive the async backend), only its pointer is kept
+template <typename... Args>
+inline void LoggerRecordDeferred(LogTypes _type, const char* _message, Args... _args)
+{
+  // Discarded inside a sink as LoggerSubmit does
+  if (!LoggerIsEnabled(_type) || LoggerInSink())
+    return;
+
+  LoggerAsyncState& async = LoggerGetAsyncState();
+  if (!async.running.load(std::memory_order_acquire))
+  {
+    LoggerAssembleLine(_type, _message, (LoggerDeferred::Stored<Args>)_args...);
+    return;
+  }
+
+  constexpr size_t fixedSize = (LoggerDeferred::FixedSize<LoggerDeferred::Stored<Args>>() + ... + 0);
+  static_assert(fixedSize <= sizeof(LogRecord::message), "Too many deferred log arguments");
+
+  size_t position;
+  LogRecord* record = async.Acquire(_type, 1, &position);
+
+  if (record != nullptr)
+  {
+    record->type = _type;
+    record->decode = &LoggerDeferred::Format<LoggerDeferred::Stored<Args>...>;
+    record->format = _message;
+    record->timestamp = LoggerTimestamp();
+    record->thread = LoggerThreadId();
+    record->span = 1;
+    record->prefixed = true;
+
+    unsigned char* arguments = (unsigned char*)record->message;
+    size_t stringSpace = sizeof(record->message) - fixedSize;
+    (LoggerDeferred::Encode<LoggerDeferred::Stored<Args>>(arguments, stringSpace, _args), ...);
+    (void)arguments;
+    (void)stringSpace;
+
+    async.Publish(position);
+  }
+
+  if (_type == Log_Type_Fatal)
+    LoggerFlushWritten();
+}
+
+//=========================
+// Typed formatting
+//=========================
+// Define YTOOLS_LOG_TYPED to have the log macros take "{}" placeholders instead of printf conversions
+// > Arguments are written by their type straight into the thread's buffer, without allocating
+// > "{{" and "}}" write a literal brace
+// > The format must be a string literal, its placeholder count is checked against the arguments at compile time
+// > Supported arguments: integers, floating point, bool, char, strings, pointers, and enums (as their value)
+
+namespace LoggerTyped {
+
+// Returns the number of "{}" in _format, or (size_t)-1 if a brace is unmatched
+constexpr size_t CountPlaceholders(const char* _format)
+{
+  size_t count = 0;
+  for (const char* c = _format; *c != '\0'; c++)
+  {
+    if (*c == '{')
+    {
+      if (c[1] == '{')
+        c++;
+      else if (c[1] == '}')
+      {
+        count++;
+        c++;
+      }
+      else
+        return (size_t)-1;
+    }
+    else if (*c == '}')
+    {
+      if (c[1] != '}')
+        return (size_t)-1;
+      c++;
+    }
+  }
+  return count;
 }
+
+// Only used in decltype, to count a macro's arguments
+template <typename... Args>
+std::integral_constant<size_t, sizeof...(Args)> CountArguments(const Args&...);
+
+// Writes into a bounded range, noting whether anything was cut off
+struct Writer
+{
+  char* position;
+  char* end;
+  bool truncated = false;
+
+  void Write(const char* _text, size_t _length)
+  {
+    const size_t space = (size_t)(end - position);
+    if (_length > space)
+    {
+      _length = space;
+      truncated = true;
+    }
+
+    memcpy(position, _text, _length);
+    position += _length;
+  }
+
+  // Writes with std::to_chars, _arguments follow the value
+  template <typename Type, typename... Args>
+  void WriteChars(Type _value, Args... _arguments)
+  {
+    std::to_chars_result result = std::to_chars(position, end, _value, _arguments...);
+    if (result.ec == std::errc())
+      position = result.ptr;
+    else
+      truncated = true;
+  }
+};
+
+template <typename Type>
+inline void WriteArgument(Writer& _writer, const Type& _value)
+{
+  if constexpr (std::is_same_v<Type, bool>)
+  {
+    if (_value)
+      _writer.Write("true", 4);
+    else
+      _writer.Write("false", 5);
+  }
+  else if constexpr (std::is_same_v<Type, char>)
+    _writer.Write(&_value, 1);
+  else if constexpr (std::is_integral_v<Type>)
+    _writer.WriteChars(_value);
+  else if constexpr (std::is_enum_v<Type>)
+    _writer.WriteChars((std::underlying_type_t<Type>)_value);
+  else if constexpr (std::is_floating_point_v<Type>)
+  {
+#if defined(__cpp_lib_to_chars)
+    _writer.WriteChars(_value);
+#else
+    char text[32];
+    int length = snprintf(text, sizeof(text), "%g", (double)_value);
+    _writer.Write(text, (length > 0) ? (size_t)length : 0);
+#endif // __cpp_lib_to_chars
+  }
+  else if constexpr (std::is_convertible_v<const Type&, std::string_view>)
+  {
+    if constexpr (std::is_pointer_v<Type>)
+    {
+      if (_value == nullptr)
+      {
+        _writer.Write("(null)", 6);
+        return;
+      }
+    }
+
+    std::string_view text(_value);
+    _writer.Write(text.data(), text.size());
+  }
+  else if constexpr (std::is_pointer_v<Type> || std::is_null_pointer_v<Type>)
+  {
+    _writer.Write("0x", 2);
+    _writer.WriteChars((uintptr_t)_value, 16);
+  }
+  else
+    static_assert(!sizeof(Type), "Unsupported log argument type");
+}
+
+// Writes _format up to its next placeholder, unescaping braces
+// Returns the position after the placeholder, or the end of _format
+inline const char* WriteLiteral(Writer& _writer, const char* _format)
+{
+  while (*_format != '\0')
+  {
+    const char* brace = _format + strcspn(_format, "{}");
+    _writer.Write(_format, (size_t)(brace - _format));
+
+    if (*brace == '\0')
+      return brace;
+
+    if (brace[0] == '{' && brace[1] == '}')
+      return brace + 2;
+
+    // An escaped brace, or an unmatched one written as is
+    _writer.Write(brace, 1);
+    _format = (brace[0] == brace[1]) ? brace + 2 : brace + 1;
+  }
+  return _format;
+}
+
+inline void WriteFormat(Writer& _writer, const char* _format)
+{
+  WriteLiteral(_writer, _format);
+}
+
+template <typename First, typename... Rest>
+inline void WriteFormat(Writer& _writer, const char* _format, const First& _first, const Rest&... _rest)
+{
+  _format = WriteLiteral(_writer, _format);
+  WriteArgument(_writer, _first);
+  WriteFormat(_writer, _format, _rest...);
+}
+
+// Formats the line into the thread's buffer at _offset, doubling the buffer while it is too small
+// Returns the text's length from _offset, including the newline
+template <typename... Args>
+inline size_t FormatLine(LoggerThreadBuffer& _buffer, size_t _offset, const char* _format, const Args&... _args)
+{
+  while (true)
+  {
+    // Room is kept for the newline and terminator
+    Writer writer { _buffer.data.get() + _offset, _buffer.data.get() + _buffer.size - 2 };
+    WriteFormat(writer, _format, _args...);
+
+    if (!writer.truncated || _buffer.size == LoggerThreadBuffer::capacity)
+    {
+      *writer.position++ = '\n';
+      *writer.position = '\0';
+      return (size_t)(writer.position - (_buffer.data.get() + _offset));
+    }
+
+    _buffer.Reserve(_buffer.size * 2);
+  }
+}
+
+} // namespace LoggerTyped
+
+// Formats "{}" placeholders with the arguments in order and writes the line
+// > The log macros check the placeholder count when YTOOLS_LOG_TYPED is defined, direct calls are not checked
+template <typename... Args>
+inline void LoggerTypedLine(LogTypes _type, const char* _format, const Args&... _args)
+{
+  if (!LoggerIsEnabled(_type))
+    return;
+
+  const int64_t timestamp = LoggerTimestamp();
+  LoggerThreadBuffer& buffer = LoggerGetThreadBuffer();
+
+  const size_t length = LoggerTyped::FormatLine(buffer, logPrefixMaxLength, _format, _args...);
+  LoggerSubmit(_type, true, timestamp, buffer, logPrefixMaxLength, length);
+}
+
+//=========================
+// Rate limiting
+//=========================
+struct LogSiteLimit;
+inline void LoggerRegisterSuppressedSite(LogSiteLimit* _site);
+inline void LoggerReportSuppressed(LogSiteLimit& _site);
+
+// A site still refusing messages writes its count at most this often, in nanoseconds
+constexpr int64_t logSuppressedReportInterval = 1000000000;
+// Refusals between checks of the clock for a periodic report, a power of 2
+constexpr uint64_t logSuppressedCheckInterval = 64;
+
+// State for one call site of LogEveryN, LogFirstN, LogEveryMs, or LogRateLimit
+// > Declared static by the macros, constant-initialized so it needs no guard or lock
+struct LogSiteLimit
+{
+  const LogTypes type;
+  const char* const file;
+  const int line;
+
+  std::atomic<uint64_t> calls { 0 };
+  std::atomic<int64_t> allowedAt { 0 };     // Earliest time the bucket is full enough for the next message
+  std::atomic<uint64_t> suppressed { 0 };   // Messages refused by EveryN and Take since the last report
+  std::atomic<uint64_t> firstLimit { 0 };   // FirstN's _n + 1, set by its first refused call
+  std::atomic<uint64_t> firstReported { 0 }; // Calls past FirstN's limit already reported
+  std::atomic<int64_t> reportAt { 0 };      // Earliest time of the next periodic report, 0 until listed
+  std::atomic<bool> registered { false };   // Listed for LoggerReportAllSuppressed, on the first refused message
+  LogSiteLimit* next = nullptr;            // Next listed site, set before this one is listed
+
+  constexpr LogSiteLimit(LogTypes _type, const char* _file, int _line) : type(_type), file(_file), line(_line)
+  {}
+
+  // True for the 1st, (_n + 1)th, (2 * _n + 1)th... call
+  bool EveryN(uint64_t _n)
+  {
+    const uint64_t call = calls.fetch_add(1, std::memory_order_relaxed);
+    if (_n <= 1 || call % _n == 0)
+      return true;
+
+    Refuse();
+    return false;
+  }
+
+  // True for the first _n calls
+  // > A refused call is a single add, the refused count is read from the calls past the limit when reported
+  bool FirstN(uint64_t _n)
+  {
+    const uint64_t call = calls.fetch_add(1, std::memory_order_relaxed);
+    if (call < _n)
+      return true;
+
+    if (call == _n)
+    {
+      firstLimit.store(_n + 1, std::memory_order_release);
+      Register();
+    }
+    else if (ReportDue(call - _n))
+      LoggerReportSuppressed(*this);
+
+    return false;
+  }
+
+  // Token bucket holding _burst messages, refilled by one every _interval nanoseconds
+  // > Kept as the time the bucket would be full again, so taking a token is a single compare-exchange
+  bool Take(int64_t _interval, unsigned int _burst)
+  {
+    const int64_t now = LoggerTimestamp();
+    const int64_t limit = (int64_t)(_burst > 0 ? _burst - 1 : 0) * _interval;
+    int64_t at = allowedAt.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+      const int64_t start = (at > now) ? at : now;
+      if (start - now > limit)
+      {
+        Refuse();
+        return false;
+      }
+
+      if (allowedAt.compare_exchange_weak(at, start + _interval, std::memory_order_relaxed))
+        return true;
+    }
+  }
+
+  // Counts a refused message, listing the site the first time
+  void Refuse()
+  {
+    const uint64_t refused = suppressed.fetch_add(1, std::memory_order_relaxed) + 1;
+    Register();
+
+    if (ReportDue(refused))
+      LoggerReportSuppressed(*this);
+  }
+
+  // Lists the site for LoggerReportAllSuppressed, once
+  void Register()
+  {
+    if (!registered.load(std::memory_order_relaxed) && !registered.exchange(true, std::memory_order_relaxed))
+    {
+      reportAt.store(LoggerTimestamp() + logSuppressedReportInterval, std::memory_order_relaxed);
+      LoggerRegisterSuppressedSite(this);
+    }
+  }
+
+  // True for one caller once logSuppressedReportInterval has passed since the site was listed or last reported
+  // > Only every logSuppressedCheckInterval-th refusal reads the clock
+  bool ReportDue(uint64_t _refused)
+  {
+    if ((_refused & (logSuppressedCheckInterval - 1)) != 0)
+      return false;
+
+    const int64_t now = LoggerTimestamp();
+    int64_t at = reportAt.load(std::memory_order_relaxed);
+    return at != 0 && now >= at &&
+           reportAt.compare_exchange_strong(at, now + logSuppressedReportInterval, std::memory_order_relaxed);
+  }
+
+  // Returns and resets the number of refused messages
+  uint64_t TakeSuppressed()
+  {
+    uint64_t count = 0;
+    if (suppressed.load(std::memory_order_relaxed) != 0)
+      count = suppressed.exchange(0, std::memory_order_relaxed);
+
+    // Acquire, so the calls read include the one that set the limit
+    const uint64_t limit = firstLimit.load(std::memory_order_acquire);
+    if (limit != 0)
+    {
+      const uint64_t refused = calls.load(std::memory_order_relaxed) - (limit - 1);
+      uint64_t reported = firstReported.load(std::memory_order_relaxed);
+      while (reported < refused &&
+             !firstReported.compare_exchange_weak(reported, refused, std::memory_order_relaxed))
+      {}
+
+      if (reported < refused)
+        count += refused - reported;
+    }
+
+    return count;
+  }
+};
+
+// Every site that has refused a message, newest first
+// > Sites are static and never removed, so the list is only ever pushed to
+inline std::atomic<LogSiteLimit*>& LoggerGetSuppressedSites()
+{
+  static std::atomic<LogSiteLimit*> head { nullptr };
+  return head;
+}
+
+// Writes the number of messages the site refused since its last report, if any
+// _buffer : Formatted into at logPrefixMaxLength, a local buffer once thread buffers are destroyed at exit
+inline void LoggerReportSuppressed(LogSiteLimit& _site, LoggerThreadBuffer& _buffer)
+{
+  const uint64_t count = _site.TakeSuppressed();
+  if (count == 0 || !LoggerIsEnabled(_site.type))
+    return;
+
+  const size_t available = _buffer.size - logPrefixMaxLength - 1;
+  int written = snprintf(_buffer.data.get() + logPrefixMaxLength, available, "[Ytools] %llu messages suppressed at %s:%d\n",
+                         (unsigned long long)count, _site.file, _site.line);
+  size_t length = (written < 0) ? 0 : (size_t)written;
+  if (length >= available)
+  {
+    length = available - 1;
+    _buffer.data[logPrefixMaxLength + length - 1] = '\n';
+  }
+
+  LoggerSubmit(_site.type, true, LoggerTimestamp(), _buffer, logPrefixMaxLength, length);
+}
+
+// Written after a rate-limited message when earlier ones from its call site were refused
+inline void LoggerReportSuppressed(LogSiteLimit& _site)
+{
+  LoggerReportSuppressed(_site, LoggerGetThreadBuffer());
+}
+
+// Reports every site's pending refused messages, see LoggerFlush
+// _buffer : As LoggerReportSuppressed
+inline void LoggerReportAllSuppressed(LoggerThreadBuffer& _buffer)
+{
+  for (LogSiteLimit* site = LoggerGetSuppressedSites().load(std::memory_order_acquire); site != nullptr; site = site->next)
+    LoggerReportSuppressed(*site, _buffer);
+}
+
+inline void LoggerReportAllSuppressed()
+{
+  LoggerReportAllSuppressed(LoggerGetThreadBuffer());
+}
+
+// Reports messages refused since each site's last accepted one when the program exits
+struct LoggerSuppressedAtExit
+{
+  // The async state and output are constructed first so they outlive this
+  LoggerSuppressedAtExit()
+  {
+    LoggerGetAsyncState();
+  }
+
+  // Thread buffers are destroyed before statics, so the reports use their own
+  ~LoggerSuppressedAtExit()
+  {
+    LoggerThreadBuffer buffer;
+    LoggerReportAllSuppressed(buffer);
+    LoggerFlushWritten();
+  }
+};
+
+inline void LoggerRegisterSuppressedSite(LogSiteLimit* _site)
+{
+  static LoggerSuppressedAtExit atExit;
+
+  std::atomic<LogSiteLimit*>& head = LoggerGetSuppressedSites();
+  LogSiteLimit* first = head.load(std::memory_order_relaxed);
+  do
+    _site->next = first;
+  while (!head.compare_exchange_weak(first, _site, std::memory_order_release, std::memory_order_relaxed));
+}
+
+} // namespace Ytools
+
+// ", ##__VA_ARGS__" drops the comma when a message has no arguments
+#if defined(YTOOLS_LOG_TYPED)
+#define YTOOLS_LOG_LINE(type, message, ...)                                                   \
+{                                                                                             \
+  static_assert(Ytools::LoggerTyped::CountPlaceholders(message)                               \
+                == decltype(Ytools::LoggerTyped::CountArguments(__VA_ARGS__))::value,         \
+                "Log placeholders do not match the arguments");                               \
+  Ytools::LoggerTypedLine(type, message, ##__VA_ARGS__);                                      \
+}
+#elif defined(YTOOLS_LOG_DEFERRED)
+#define YTOOLS_LOG_LINE(type, message, ...) Ytools::LoggerRecordDeferred(type, message, ##__VA_ARGS__)
+#else
+#define YTOOLS_LOG_LINE(type, message, ...) Ytools::LoggerAssembleLine(type, message, ##__VA_ARGS__)
+#endif // YTOOLS_LOG_TYPED
+
+// The runtime level is checked first, so disabled messages do not evaluate their arguments
+#define YTOOLS_LOG_IF_ENABLED(type, message, ...)               \
+{                                                               \
+  if (Ytools::LoggerIsEnabled(type))                            \
+    YTOOLS_LOG_LINE(type, message, ##__VA_ARGS__);              \
+}
+
+#if YTOOLS_LOG_MIN_LEVEL <= 0
+#define LogInfo(message, ...) YTOOLS_LOG_IF_ENABLED(Ytools::Log_Type_Info, message, ##__VA_ARGS__)
 #else
 #define LogInfo(message, ...)
+#endif
+
+#if YTOOLS_LOG_MIN_LEVEL <= 1
+#define LogDebug(message, ...) YTOOLS_LOG_IF_ENABLED(Ytools::Log_Type_Debug, message, ##__VA_ARGS__)
+#else
 #define LogDebug(message, ...)
+#endif
+
+#if YTOOLS_LOG_MIN_LEVEL <= 2
+#define LogWarning(message, ...) YTOOLS_LOG_IF_ENABLED(Ytools::Log_Type_Warning, message, ##__VA_ARGS__)
+#else
 #define LogWarning(message, ...)
-#endif // ICE_DEBUG
+#endif
 
-#define LogError(message, ...)                                      \
-{                                                                   \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Error, message, __VA_ARGS__); \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Error, "\n");                 \
-}
+#if YTOOLS_LOG_MIN_LEVEL <= 3
+#define LogError(message, ...) YTOOLS_LOG_IF_ENABLED(Ytools::Log_Type_Error, message, ##__VA_ARGS__)
+#else
+#define LogError(message, ...)
+#endif
 
-#define LogFatal(message, ...)                                      \
-{                                                                   \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Fatal, message, __VA_ARGS__); \
-  Ytools::LoggerAssembleMessage(Ytools::Log_Type_Fatal, "\n");                 \
+#if YTOOLS_LOG_MIN_LEVEL <= 4
+#define LogFatal(message, ...) YTOOLS_LOG_IF_ENABLED(Ytools::Log_Type_Fatal, message, ##__VA_ARGS__)
+#else
+#define LogFatal(message, ...)
+#endif
+
+// Rate-limited variants =====
+// level : Info, Debug, Warning, Error, or Fatal
+// > Each call site keeps its own count of refused messages
+// > The count is written after the site's next accepted message, and by LoggerFlush, LoggerStopAsync, and at exit
+// > A site that keeps refusing also writes it about every logSuppressedReportInterval, from a refused call
+
+// Writes the message when the site accepts it, then any count of messages it refused before
+#define YTOOLS_LOG_LIMITED(level, accept, message, ...)                                       \
+{                                                                                             \
+  static Ytools::LogSiteLimit ytoolsLogSite { Ytools::Log_Type_##level, __FILE__, __LINE__ }; \
+  if (Ytools::LoggerIsEnabled(Ytools::Log_Type_##level) && ytoolsLogSite.accept)              \
+  {                                                                                           \
+    YTOOLS_LOG_LINE(Ytools::Log_Type_##level, message, ##__VA_ARGS__);                        \
+    Ytools::LoggerReportSuppressed(ytoolsLogSite);                                            \
+  }                                                                                           \
 }
 
+// Writes the 1st of every _n calls
+#define LogEveryN(level, n, message, ...) YTOOLS_LOG_LIMITED(level, EveryN(n), message, ##__VA_ARGS__)
+
+// Writes only the first _n calls
+#define LogFirstN(level, n, message, ...) YTOOLS_LOG_LIMITED(level, FirstN(n), message, ##__VA_ARGS__)
+
+// Writes up to burst messages at once, refilled by one every ms milliseconds
+#define LogRateLimit(level, ms, burst, message, ...)                                          \
+  YTOOLS_LOG_LIMITED(level, Take((int64_t)(ms) * 1000000, burst), message, ##__VA_ARGS__)
+
+// Writes at most one message every ms milliseconds
+#define LogEveryMs(level, ms, message, ...) LogRateLimit(level, ms, 1, message, ##__VA_ARGS__)
+
 #endif // YTOOLS_LOGGER_H_
 